@@ -70,4 +70,67 @@ bool DefaultEffector :: MergeEffects(string expr, vector<Effect> effects, vector
     }
 
     return result;
+}
+
+/**
+ * NewStream creates a stream that stops at the first rule deciding the built-in effect.
+ */
+shared_ptr<EffectorStream> DefaultEffector :: NewStream(string expr) {
+    if (!expr.compare("some(where (p.eft == allow))"))
+        return shared_ptr<EffectorStream>(new DefaultEffectorStream(DefaultEffectorStream::Kind::AllowOverride));
+    if (!expr.compare("!some(where (p.eft == deny))"))
+        return shared_ptr<EffectorStream>(new DefaultEffectorStream(DefaultEffectorStream::Kind::DenyOverride));
+    if (!expr.compare("some(where (p.eft == allow)) && !some(where (p.eft == deny))"))
+        return shared_ptr<EffectorStream>(new DefaultEffectorStream(DefaultEffectorStream::Kind::AllowAndDeny));
+    if (!expr.compare("priority(p.eft) || deny"))
+        return shared_ptr<EffectorStream>(new DefaultEffectorStream(DefaultEffectorStream::Kind::Priority));
+
+    // MergeEffects reports the unsupported effect when the decision is asked for.
+    return Effector::NewStream(expr);
+}
+
+DefaultEffectorStream :: DefaultEffectorStream(Kind kind) {
+    this->kind = kind;
+    this->Reset();
+}
+
+void DefaultEffectorStream :: Reset() {
+    this->decision = this->kind == Kind::DenyOverride;
+}
+
+bool DefaultEffectorStream :: PushEffect(Effect effect, float result) {
+    switch (this->kind) {
+        case Kind::AllowOverride:
+            if (effect == Effect::Allow) {
+                this->decision = true;
+                return true;
+            }
+            return false;
+        case Kind::DenyOverride:
+            if (effect == Effect::Deny) {
+                this->decision = false;
+                return true;
+            }
+            return false;
+        case Kind::AllowAndDeny:
+            if (effect == Effect::Allow)
+                this->decision = true;
+            else if (effect == Effect::Deny) {
+                this->decision = false;
+                return true;
+            }
+            return false;
+        case Kind::Priority:
+            if (effect != Effect::Indeterminate) {
+                this->decision = effect == Effect::Allow;
+                return true;
+            }
+            return false;
+    }
+
+    return false;
+}
+
+bool DefaultEffectorStream :: Decision() {
+    return this->decision;
 }
\ No newline at end of file
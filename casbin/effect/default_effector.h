@@ -29,6 +29,34 @@ class DefaultEffector : public Effector{
          * MergeEffects merges all matching results collected by the enforcer into a single decision.
          */
         bool MergeEffects(string expr, vector<Effect> effects, vector<float> results);
+
+        /**
+         * NewStream creates a stream that stops at the first rule deciding the built-in effect.
+         */
+        shared_ptr<EffectorStream> NewStream(string expr);
+};
+
+/**
+ * DefaultEffectorStream merges the effects of the built-in [policy_effect] expressions rule by rule.
+ */
+class DefaultEffectorStream : public EffectorStream{
+    public:
+        enum Kind{
+            AllowOverride, DenyOverride, AllowAndDeny, Priority
+        };
+
+    private:
+        Kind kind;
+        bool decision;
+
+    public:
+        DefaultEffectorStream(Kind kind);
+
+        void Reset();
+
+        bool PushEffect(Effect effect, float result);
+
+        bool Decision();
 };
 
 #endif
\ No newline at end of file
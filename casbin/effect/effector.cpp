@@ -0,0 +1,49 @@
+/*
+* Copyright 2020 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "pch.h"
+
+#include "./effector.h"
+
+/**
+ * NewStream creates a stream that merges the effects of one request at a time, it is reset for every request.
+ * By default the effects are collected and merged with MergeEffects once all rules have been pushed.
+ */
+shared_ptr<EffectorStream> Effector :: NewStream(string expr) {
+    return shared_ptr<EffectorStream>(new MergingEffectorStream(this, expr));
+}
+
+MergingEffectorStream :: MergingEffectorStream(Effector* eft, string expr) {
+    this->eft = eft;
+    this->expr = expr;
+}
+
+void MergingEffectorStream :: Reset() {
+    this->effects.clear();
+    this->results.clear();
+}
+
+bool MergingEffectorStream :: PushEffect(Effect effect, float result) {
+    this->effects.push_back(effect);
+    this->results.push_back(result);
+    return false;
+}
+
+bool MergingEffectorStream :: Decision() {
+    return this->eft->MergeEffects(this->expr, this->effects, this->results);
+}
\ No newline at end of file
@@ -17,6 +17,7 @@
 #ifndef CASBIN_CPP_EFFECT_EFFECTOR
 #define CASBIN_CPP_EFFECT_EFFECTOR
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -24,6 +25,32 @@
 
 using namespace std;
 
+/**
+ * EffectorStream merges the effects of the rules of one request while they are evaluated,
+ * so that the enforcer can stop as soon as the decision is final.
+ */
+class EffectorStream{
+    public:
+        /**
+         * Reset starts merging the effects of a new request.
+         */
+        virtual void Reset() = 0;
+
+        /**
+         * PushEffect merges the effect of the next rule, rules are pushed in policy order.
+         *
+         * @param effect the effect of the rule, Indeterminate if it did not match.
+         * @param result the matcher result of the rule.
+         * @return true if the decision is final and the remaining rules do not need to be evaluated.
+         */
+        virtual bool PushEffect(Effect effect, float result) = 0;
+
+        /**
+         * Decision returns the decision for the effects pushed so far.
+         */
+        virtual bool Decision() = 0;
+};
+
 /**
  * Effector is the abstract class for Casbin effectors.
  */
@@ -38,6 +65,35 @@ class Effector{
          * @return the final effect.
          */
         virtual bool MergeEffects(string expr, vector<Effect> effects, vector<float> results) = 0;
+
+        /**
+         * NewStream creates a stream that merges the effects of one request at a time, it is reset for every request.
+         * By default the effects are collected and merged with MergeEffects once all rules have been pushed.
+         *
+         * @param expr the expression of [policy_effect].
+         * @return the stream.
+         */
+        virtual shared_ptr<EffectorStream> NewStream(string expr);
+};
+
+/**
+ * MergingEffectorStream collects the effects of a request and merges them with Effector::MergeEffects.
+ */
+class MergingEffectorStream : public EffectorStream{
+    private:
+        Effector* eft;
+        string expr;
+        vector<Effect> effects;
+        vector<float> results;
+
+    public:
+        MergingEffectorStream(Effector* eft, string expr);
+
+        void Reset();
+
+        bool PushEffect(Effect effect, float result);
+
+        bool Decision();
 };
 
 #endif
\ No newline at end of file
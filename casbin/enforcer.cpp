@@ -31,7 +31,7 @@
 #include "./util/util.h"
 
 // enforce use a custom matcher to decides whether a "subject" can access a "object" with the operation "action", input parameters are usually: (matcher, sub, obj, act), use model matcher by default when matcher is "".
-bool Enforcer :: enforce(string matcher, Scope scope) {
+bool Enforcer :: enforce(string matcher, FunctionMap& fm, EvaluationContext& context, shared_ptr<Matcher> candidates_matcher, const vector<string>* r_vals) {
     // TODO
     // defer func() {
     // 	if err := recover(); err != nil {
@@ -39,127 +39,302 @@ bool Enforcer :: enforce(string matcher, Scope scope) {
     // 	}
     // }()
 
-    this->func_map.scope = scope;
-    this->func_map.LoadFunctionMap();
-
     if(!this->enabled)
         return true;
 
+    // Values left on the stack by the evaluation are dropped on every exit, so that a long-lived scope does not grow.
+    StackGuard guard(fm.scope);
+    unsigned int top = Size(fm.scope);
+
     // for(unordered_map <string, Function> :: iterator it = this->fm.fmap.begin() ; it != this->fm.fmap.end() ; it++)
     // 	this->fm.AddFunction(it->first, it->second);
 
-    string exp_string;
-    if(matcher == "")
-        exp_string = this->model->m["m"].assertion_map["m"]->value;
-    else
-        exp_string = matcher;
-
-
-    unordered_map <string, shared_ptr<RoleManager>> rm_map;
-    bool ok = this->model->m.find("g") != this->model->m.end();
+    const ModelHandles& handles = this->handles;
+    const string& exp_string = matcher == "" ? handles.m->value : matcher;
+    const vector<string>& p_tokens = handles.p->tokens;
 
-    if(ok) {
-        for(unordered_map <string, shared_ptr<Assertion>> :: iterator it = this->model->m["g"].assertion_map.begin() ; it != this->model->m["g"].assertion_map.end() ; it++){
-            shared_ptr<RoleManager> rm = it->second->rm;
-            int char_count = int(count(it->second->value.begin(), it->second->value.end(), '_'));
-            int index = int(exp_string.find((it->first)+"("));
-            if(index != string::npos)
-                exp_string.insert(index+(it->first+"(").length(), "rm, ");
-            PushPointer(this->func_map.scope, (void *)rm.get(), "rm");
-            this->func_map.AddFunction(it->first, GFunction, char_count + 1);
-        }
-    }
-
-    unordered_map <string, int> p_int_tokens;
-    for(int i = 0 ; i < this->model->m["p"].assertion_map["p"]->tokens.size() ; i++)
-        p_int_tokens[this->model->m["p"].assertion_map["p"]->tokens[i]] = i;
+    // The rules are read through a view, which keeps them alive while they are evaluated.
+    PolicyView policy = handles.p->View();
+    int policy_len = policy.Size();
+    if(candidates_matcher != NULL)
+        candidates_matcher->LookupRequest(policy, *r_vals, context.request_symbols);
+    RuleList rules = this->CandidateRules(policy, candidates_matcher, context.request_symbols);
 
-    vector <string> p_tokens = this->model->m["p"].assertion_map["p"]->tokens;
+    // The effects are merged while the rules are evaluated, so the loop stops once the decision is final.
+    EffectorStream* effects = context.effects.get();
+    effects->Reset();
 
-    int policy_len = int(this->model->m["p"].assertion_map["p"]->policy.size());
-
-    vector <Effect> policy_effects(policy_len, Effect :: Indeterminate);
-    vector <float> matcher_results;
+    // The compiled matcher takes "r" and "p" as arguments, so it is not parsed again for every policy rule.
+    bool compiled = this->compiled_matcher && fm.CompileMatcher(exp_string);
 
     if(policy_len != 0) {
-        if(this->model->m["r"].assertion_map["r"]->tokens.size() != this->func_map.GetRLen())
+        if(handles.r->tokens.size() != fm.GetRLen())
             return false;
 
+        fm.PreparePolicy(p_tokens);
+
+        // The effects are looked up in the symbol table of the view, a policy that is loaded again has a new one.
+        const SymbolTable& symbols = policy.Symbols();
+        int allow = symbols.Find("allow");
+        int deny = symbols.Find("deny");
+
         //TODO
-        for( int i = 0 ; i < policy_len ; i++){
+        for(RuleList :: Iterator it = rules.begin() ; it != rules.end() ; ++it){
+            int i = *it;
+            if(policy.IsRemoved(i))
+                continue;
             // log.LogPrint("Policy Rule: ", pvals)
-            vector<string> p_vals = this->model->m["p"].assertion_map["p"]->policy[i];
-            if(this->model->m["p"].assertion_map["p"]->tokens.size() != p_vals.size())
+            SetSize(fm.scope, top);
+            PolicyView :: Rule p_rule = policy.RuleAt(i);
+            if(p_tokens.size() != p_rule.Size())
                 return false;
 
-            PushObject(this->func_map.scope, "p");
-            for(int j = 0 ; j < p_tokens.size() ; j++){
-                int index = int(p_tokens[j].find("_"));
-                string token = p_tokens[j].substr(index+1);
-                PushStringPropToObject(this->func_map.scope, "p", p_vals[j], token);
-            }
+            fm.BindPolicy(p_rule);
 
-            this->func_map.Evaluate(exp_string);
+            if(compiled)
+                fm.EvaluateCompiled();
+            else
+                fm.Evaluate(exp_string);
 
             //TODO
             // log.LogPrint("Result: ", result)
-            if(CheckType(this->func_map.scope) == Type :: Bool){
-                bool result = GetBoolean(this->func_map.scope);
+            float matcher_result = 0;
+            if(CheckType(fm.scope) == Type :: Bool){
+                bool result = GetBoolean(fm.scope);
                 if(!result) {
-                    policy_effects[i] = Effect :: Indeterminate;
+                    if(effects->PushEffect(Effect :: Indeterminate, 0))
+                        break;
                     continue;
                 }
             }
-            else if(CheckType(this->func_map.scope) == Type :: Float){
-                bool result = GetFloat(this->func_map.scope);
+            else if(CheckType(fm.scope) == Type :: Float){
+                bool result = GetFloat(fm.scope);
                 if(result == 0) {
-                    policy_effects[i] = Effect :: Indeterminate;
+                    if(effects->PushEffect(Effect :: Indeterminate, 0))
+                        break;
                     continue;
                 } else
-                    matcher_results[i] = result;
+                    matcher_result = result;
             }
             else
                 return false;
 
-            bool is_p_eft = p_int_tokens.find("p_eft") != p_int_tokens.end();
-            if(is_p_eft) {
-                int j = p_int_tokens["p_eft"];
-                string eft = p_vals[j];
-                if(eft == "allow")
-                    policy_effects[i] = Effect :: Allow;
-                else if(eft == "deny")
-                    policy_effects[i] = Effect :: Deny;
+            Effect effect;
+            if(handles.p_eft_index != -1) {
+                int eft = p_rule.Symbol(handles.p_eft_index);
+                if(eft == allow)
+                    effect = Effect :: Allow;
+                else if(eft == deny)
+                    effect = Effect :: Deny;
                 else
-                    policy_effects[i] = Effect :: Indeterminate;
+                    effect = Effect :: Indeterminate;
             }
             else
-                policy_effects[i] = Effect :: Allow;
+                effect = Effect :: Allow;
 
-            if(this->model->m["e"].assertion_map["e"]->value == "priority(p_eft) || deny")
+            if(effects->PushEffect(effect, matcher_result))
                 break;
         }
     } else {
-        bool isValid = this->func_map.Evaluate(exp_string);
+        // A policy object left by a previous request must not be visible to the matcher.
+        PushUndefined(fm.scope, "p");
+        bool isValid = compiled ? fm.EvaluateCompiled() : fm.Evaluate(exp_string);
         if(!isValid)
             return false;
-        bool result = this->func_map.GetBooleanResult();
+        bool result = fm.GetBooleanResult();
 
         //TODO
         // log.LogPrint("Result: ", result)
         if(result)
-            policy_effects.push_back(Effect::Allow);
+            effects->PushEffect(Effect::Allow, 0);
         else
-            policy_effects.push_back(Effect::Indeterminate);
+            effects->PushEffect(Effect::Indeterminate, 0);
     }
 
     //TODO
     // log.LogPrint("Rule Results: ", policyEffects)
 
-    bool result = this->eft->MergeEffects(this->model->m["e"].assertion_map["e"]->value, policy_effects, matcher_results);
+    return effects->Decision();
+}
 
+// enforce use a custom matcher to decides whether a "subject" can access a "object" with the operation "action", the request is read from a scope created by the caller.
+bool Enforcer :: enforce(string matcher, Scope scope) {
+    FunctionMap fm(scope);
+    for(unordered_map<string, Function> :: iterator it = this->func_map.func_map.begin() ; it != this->func_map.func_map.end() ; it++)
+        fm.AddFunction(it->first, it->second, this->func_map.func_nargs[it->first]);
+    for(unordered_map<string, pair<shared_ptr<RoleManager>*, Index>> :: iterator it = this->func_map.g_func_map.begin() ; it != this->func_map.g_func_map.end() ; it++)
+        fm.AddGFunction(it->first, it->second.first, it->second.second);
+
+    shared_ptr<EvaluationContext> context = this->AcquireContext();
+    bool result = this->enforce(matcher, fm, *context);
+    this->ReleaseContext(context);
     return result;
 }
 
+// enforce evaluates a native matcher against the request values, without the JavaScript engine.
+bool Enforcer :: enforce(shared_ptr<Matcher> matcher, const vector<string>& r_vals, EvaluationContext& context) {
+    if(!this->enabled)
+        return true;
+
+    const ModelHandles& handles = this->handles;
+    int p_len = int(handles.p->tokens.size());
+
+    // The rules are read through a view, which keeps them alive while they are evaluated.
+    PolicyView policy = handles.p->View();
+    int policy_len = policy.Size();
+
+    // The effects are merged while the rules are evaluated, so the loop stops once the decision is final.
+    EffectorStream* effects = context.effects.get();
+    effects->Reset();
+    MatcherValue value;
+
+    // The request values are looked up in the symbol table once, then they are compared with the policy values by symbol.
+    vector<int>& r_symbols = context.request_symbols;
+    matcher->LookupRequest(policy, r_vals, r_symbols);
+
+    if(policy_len != 0) {
+        // The effects are looked up in the symbol table of the view, a policy that is loaded again has a new one.
+        const SymbolTable& symbols = policy.Symbols();
+        int allow = symbols.Find("allow");
+        int deny = symbols.Find("deny");
+
+        // The sub-expressions that do not reference the policy rule are evaluated once for the request,
+        // and if they decide the matcher on their own, no rule has to be evaluated.
+        vector<MatcherValue>& invariants = context.invariants;
+        const vector<MatcherValue>* hoisted = matcher->EvaluateInvariants(r_vals, invariants) ? &invariants : NULL;
+        MatcherValue decided;
+        bool is_decided = hoisted != NULL && matcher->Decide(invariants, decided);
+
+        RuleList rules = is_decided ? (decided.Truthy() ? policy.Positions() : RuleList()) : this->CandidateRules(policy, matcher, r_symbols);
+
+        for(RuleList :: Iterator it = rules.begin() ; it != rules.end() ; ++it){
+            int i = *it;
+            if(policy.IsRemoved(i))
+                continue;
+            PolicyView :: Rule p_rule = policy.RuleAt(i);
+            if(p_len != p_rule.Size())
+                return false;
+
+            if(is_decided)
+                value = decided;
+            else if(!matcher->Evaluate(r_vals, &r_symbols, &p_rule, value, hoisted))
+                return false;
+
+            if(!value.Truthy()) {
+                if(effects->PushEffect(Effect :: Indeterminate, 0))
+                    break;
+                continue;
+            }
+            float matcher_result = value.kind == MatcherValue :: Kind :: Number ? float(value.number) : 0;
+
+            Effect effect;
+            if(handles.p_eft_index != -1) {
+                int eft = p_rule.Symbol(handles.p_eft_index);
+                if(eft == allow)
+                    effect = Effect :: Allow;
+                else if(eft == deny)
+                    effect = Effect :: Deny;
+                else
+                    effect = Effect :: Indeterminate;
+            }
+            else
+                effect = Effect :: Allow;
+
+            if(effects->PushEffect(effect, matcher_result))
+                break;
+        }
+    } else {
+        if(!matcher->Evaluate(r_vals, &r_symbols, NULL, value))
+            return false;
+
+        if(value.Truthy())
+            effects->PushEffect(Effect::Allow, 0);
+        else
+            effects->PushEffect(Effect::Indeterminate, 0);
+    }
+
+    return effects->Decision();
+}
+
+// AcquireContext checks out an evaluation context for a request, a new one is prepared with the functions,
+// the compiled model matcher and the effect stream when none is idle. It is returned with ReleaseContext().
+shared_ptr<EvaluationContext> Enforcer :: AcquireContext() {
+    shared_ptr<EvaluationContext> context = this->contexts.Acquire();
+    if(context == NULL) {
+        unsigned long generation = this->contexts.Generation();
+        context = shared_ptr<EvaluationContext>(new EvaluationContext(this->func_map, this->arena_allocator));
+        context->generation = generation;
+        if(this->compiled_matcher)
+            context->func_map.CompileMatcher(this->handles.m->value);
+        context->effects = this->eft->NewStream(this->handles.e->value);
+    }
+
+    context->arena->BeginRequest();
+    return context;
+}
+
+// ReleaseContext ends the request of a context, adds up its allocations and returns it to the pool.
+void Enforcer :: ReleaseContext(shared_ptr<EvaluationContext> context) {
+    context->arena->EndRequest();
+
+    this->allocation_totals.Add(context->arena->TakeCounts());
+
+    this->contexts.Release(context);
+}
+
+// CandidateRules returns the positions of the rules that can satisfy the equality conjuncts of the matcher for the request,
+// using the smallest list of matching rules of the column indices. It returns every rule when they have to be evaluated.
+// The rules that have been removed but are still stored in the snapshot can be among them.
+RuleList Enforcer :: CandidateRules(const PolicyView& policy, shared_ptr<Matcher> matcher, const vector<int>& r_symbols) {
+    RuleList candidates = policy.Positions();
+    if(matcher == NULL)
+        return candidates;
+
+    const vector<pair<int, int>>& conjuncts = matcher->EqualityConjuncts();
+    for(int i = 0 ; i < conjuncts.size() ; i++){
+        RuleList rules;
+        if(!policy.GetRulesByColumn(conjuncts[i].second, r_symbols[conjuncts[i].first], rules))
+            return policy.Positions();
+        if(rules.Size() < candidates.Size())
+            candidates = rules;
+    }
+
+    return candidates;
+}
+
+// BindMatcher parses a matcher expression and binds it to the current model and functions.
+shared_ptr<Matcher> Enforcer :: BindMatcher(string expression) {
+    shared_ptr<Matcher> matcher = Matcher :: NewMatcher(expression);
+    matcher->EnableReordering(this->matcher_reordering);
+
+    shared_ptr<Assertion> p = this->handles.p;
+    matcher->Bind(this->handles.r->tokens, p->tokens, this->func_map.func_map, this->handles.g);
+    return matcher;
+}
+
+// LoadMatcher prepares the model matcher once: it is parsed for native evaluation, and the g functions are bound to
+// the role manager of the enforcer, so that the matcher is not rewritten for every request.
+void Enforcer :: LoadMatcher() {
+    if(this->model == NULL)
+        return;
+
+    // Contexts prepared for the previous model or functions are not handed out any more.
+    this->contexts.Invalidate();
+
+    this->handles.Resolve(this->model.get());
+
+    this->func_map.ClearGFunctions();
+    if(this->handles.g != NULL) {
+        for(unordered_map <string, shared_ptr<Assertion>> :: iterator it = this->handles.g->begin() ; it != this->handles.g->end() ; it++){
+            int char_count = int(count(it->second->value.begin(), it->second->value.end(), '_'));
+            it->second->rm = this->rm;
+            this->func_map.AddGFunction(it->first, &(it->second->rm), char_count);
+        }
+    }
+
+    this->model_matcher = this->BindMatcher(this->handles.m->value);
+}
+
 /**
  * Enforcer is the default constructor.
  */
@@ -280,6 +455,11 @@ void Enforcer :: Initialize() {
     this->auto_save = true;
     this->auto_build_role_links = true;
     this->auto_notify_watcher = true;
+    this->compiled_matcher = true;
+    this->matcher_reordering = true;
+    this->arena_allocator = true;
+
+    this->LoadMatcher();
 }
 
 // LoadModel reloads the model from the model CONF file.
@@ -333,34 +513,40 @@ shared_ptr<RoleManager> Enforcer ::GetRoleManager() {
 // SetRoleManager sets the current role manager.
 void Enforcer :: SetRoleManager(shared_ptr<RoleManager> rm) {
     this->rm = rm;
+    this->LoadMatcher();
 }
 
 // SetEffector sets the current effector.
 void Enforcer :: SetEffector(shared_ptr<Effector> eft) {
     this->eft = eft;
+    this->contexts.Invalidate();
 }
 
 // ClearPolicy clears all policy.
 void Enforcer :: ClearPolicy() {
     this->model->ClearPolicy();
+    this->model->PublishPolicy();
 }
 
 // LoadPolicy reloads the policy from file/database.
+// The rules are loaded off to the side while enforce calls keep using the current policy, which is only replaced
+// once the loading has succeeded. If the adapter fails, the current policy is kept.
 void Enforcer :: LoadPolicy() {
-    this->ClearPolicy();
-    this->adapter->LoadPolicy(this->model.get());
+    this->model->ClearPolicy();
+    try {
+        this->adapter->LoadPolicy(this->model.get());
+    } catch (...) {
+        this->model->DiscardPolicy();
+        throw;
+    }
     this->model->PrintPolicy();
 
-    if(this->auto_build_role_links) {
-        this->BuildRoleLinks();
-    }
+    this->PublishLoadedPolicy();
 }
 
 //LoadFilteredPolicy reloads a filtered policy from file/database.
 template<typename Filter>
 void Enforcer :: LoadFilteredPolicy(Filter filter) {
-    this->ClearPolicy();
-
     shared_ptr<FilteredAdapter> filtered_adapter;
 
     if (this->adapter->IsFiltered()) {
@@ -369,11 +555,37 @@ void Enforcer :: LoadFilteredPolicy(Filter filter) {
     else
         throw CasbinAdapterException("filtered policies are not supported by this adapter");
 
-    filtered_adapter->LoadFilteredPolicy(this->model, filter);
-
+    this->model->ClearPolicy();
+    try {
+        filtered_adapter->LoadFilteredPolicy(this->model, filter);
+    } catch (...) {
+        this->model->DiscardPolicy();
+        throw;
+    }
     this->model->PrintPolicy();
-    if(this->auto_build_role_links)
-        this->BuildRoleLinks();
+
+    this->PublishLoadedPolicy();
+}
+
+// PublishLoadedPolicy builds the role links of the rules that have been loaded, then publishes the rules and the links
+// one right after the other. If the links cannot be built, the current rules and links are kept.
+void Enforcer :: PublishLoadedPolicy() {
+    if(!this->auto_build_role_links) {
+        this->model->PublishPolicy();
+        return;
+    }
+
+    this->rm->BeginUpdate();
+    try {
+        this->rm->Clear();
+        this->model->BuildRoleLinks(this->rm);
+    } catch (...) {
+        this->rm->CancelUpdate();
+        this->model->DiscardPolicy();
+        throw;
+    }
+    this->model->PublishPolicy();
+    this->rm->EndUpdate();
 }
 
 // IsFiltered returns true if the loaded policy has been filtered.
@@ -423,11 +635,49 @@ void Enforcer :: EnableAutoBuildRoleLinks(bool auto_build_role_links) {
     this->auto_build_role_links = auto_build_role_links;
 }
 
+// EnableCompiledMatcher controls whether a matcher evaluated by the JavaScript engine is compiled once into a function instead of being evaluated from source for every policy rule.
+void Enforcer :: EnableCompiledMatcher(bool compiled_matcher) {
+    this->compiled_matcher = compiled_matcher;
+    this->contexts.Invalidate();
+}
+
+// EnableMatcherReordering controls whether the operands of && and || in a natively evaluated matcher are reordered by estimated cost and selectivity.
+void Enforcer :: EnableMatcherReordering(bool matcher_reordering) {
+    this->matcher_reordering = matcher_reordering;
+    this->LoadMatcher();
+}
+
+// GetMatcherShortCircuitCounts returns, for every operand of && and || in the model matcher, how often it decided the result on its own.
+vector<pair<string, unsigned long long>> Enforcer :: GetMatcherShortCircuitCounts() {
+    if(this->model_matcher == NULL)
+        return vector<pair<string, unsigned long long>>();
+    return this->model_matcher->ShortCircuitCounts();
+}
+
+// EnableArenaAllocator controls whether the JavaScript heaps allocate the temporaries of a request from an arena that is reset after the request.
+void Enforcer :: EnableArenaAllocator(bool arena_allocator) {
+    this->arena_allocator = arena_allocator;
+    this->contexts.Invalidate();
+}
+
+// GetAllocationCounts returns the number of requests evaluated and the allocations their JavaScript heaps made,
+// divided by the requests they give the allocations per enforce call.
+AllocationCounts Enforcer :: GetAllocationCounts() {
+    return this->allocation_totals.Counts();
+}
+
 // BuildRoleLinks manually rebuild the role inheritance relations.
 void Enforcer :: BuildRoleLinks() {
-    this->rm->Clear();
-
-    this->model->BuildRoleLinks(this->rm);
+    // The links are rebuilt in one batch, so enforce calls see either all of the old links or all of the new ones.
+    this->rm->BeginUpdate();
+    try {
+        this->rm->Clear();
+        this->model->BuildRoleLinks(this->rm);
+    } catch (...) {
+        this->rm->CancelUpdate();
+        throw;
+    }
+    this->rm->EndUpdate();
 }
 
 // BuildIncrementalRoleLinks provides incremental build the role inheritance relations.
@@ -462,34 +712,69 @@ bool Enforcer :: EnforceWithMatcher(string matcher, Scope scope) {
 
 // EnforceWithMatcher use a custom matcher to decides whether a "subject" can access a "object" with the operation "action", input parameters are usually: (matcher, sub, obj, act), use model matcher by default when matcher is "".
 bool Enforcer::EnforceWithMatcher(string matcher, vector<string> params) {
-    vector <string> r_tokens = this->model->m["r"].assertion_map["r"]->tokens;
+    const vector<string>& r_keys = this->handles.r_keys;
 
-    int r_cnt = int(r_tokens.size());
+    int r_cnt = int(r_keys.size());
     int cnt = int(params.size());
 
     if (cnt != r_cnt)
         return false;
 
-    Scope scope = InitializeScope();
-    PushObject(scope, "r");
+    shared_ptr<Matcher> native_matcher = matcher == "" ? this->model_matcher : this->BindMatcher(matcher);
+    shared_ptr<EvaluationContext> context = this->AcquireContext();
+    bool result;
+    if (native_matcher != NULL && native_matcher->IsNative())
+        result = this->enforce(native_matcher, params, *context);
+    else {
+        context->func_map.ResetR();
 
-    for (int i = 0; i < cnt; i++) {
-        PushStringPropToObject(scope, "r", params[i], r_tokens[i].substr(2, r_tokens[i].size() - 2));
+        for (int i = 0; i < cnt; i++) {
+            context->func_map.AddStringPropToR(r_keys[i], params[i]);
+        }
+
+        result = this->enforce(matcher, context->func_map, *context, native_matcher, &params);
     }
+    this->ReleaseContext(context);
 
-    return this->enforce(matcher, scope);
+    return result;
 }
 
 // EnforceWithMatcher use a custom matcher to decides whether a "subject" can access a "object" with the operation "action", input parameters are usually: (matcher, sub, obj, act), use model matcher by default when matcher is "".
 bool Enforcer::EnforceWithMatcher(string matcher, unordered_map<string, string> params) {
-    Scope scope = InitializeScope();
-    PushObject(scope, "r");
+    const vector<string>& r_keys = this->handles.r_keys;
+
+    // The request can be evaluated natively when it provides exactly the fields of the request definition.
+    vector<string> r_vals;
+    shared_ptr<Matcher> native_matcher;
+    if (params.size() == r_keys.size()) {
+        for (int i = 0; i < r_keys.size(); i++) {
+            unordered_map<string, string> :: iterator it = params.find(r_keys[i]);
+            if (it == params.end())
+                break;
+            r_vals.push_back(it->second);
+        }
 
-    for (auto r : params) {
-        PushStringPropToObject(scope, "r", r.second, r.first);
+        native_matcher = matcher == "" ? this->model_matcher : this->BindMatcher(matcher);
     }
 
-    return this->enforce(matcher, scope);
+    shared_ptr<EvaluationContext> context = this->AcquireContext();
+    bool result;
+    if (r_vals.size() == r_keys.size() && native_matcher != NULL && native_matcher->IsNative())
+        result = this->enforce(native_matcher, r_vals, *context);
+    else {
+        context->func_map.ResetR();
+
+        for (auto r : params) {
+            context->func_map.AddStringPropToR(r.first, r.second);
+        }
+
+        if (r_vals.size() != r_keys.size())
+            native_matcher = NULL;
+        result = this->enforce(matcher, context->func_map, *context, native_matcher, &r_vals);
+    }
+    this->ReleaseContext(context);
+
+    return result;
 }
 
 // managemet_api and internal_api common API
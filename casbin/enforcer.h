@@ -20,6 +20,9 @@
 #include<memory>
 #include "./rbac/role_manager.h"
 #include "./model/function.h"
+#include "./model/matcher.h"
+#include "./model/evaluation_context.h"
+#include "./model/model_handles.h"
 #include "./enforcer_interface.h"
 #include "./persist/filtered_adapter.h"
 
@@ -31,8 +34,12 @@ class Enforcer : public Php::Base, public IEnforcer{
 
         string model_path;
         shared_ptr<Model> model;
+        // handles are the parts of the model that enforce calls need, resolved by LoadMatcher whenever the model is set.
+        ModelHandles handles;
         FunctionMap func_map;
+        shared_ptr<Matcher> model_matcher;
         shared_ptr<Effector> eft;
+        EvaluationContextPool contexts;
 
         shared_ptr<Adapter> adapter;
         shared_ptr<Watcher> watcher;
@@ -41,10 +48,45 @@ class Enforcer : public Php::Base, public IEnforcer{
         bool auto_save;
         bool auto_build_role_links;
         bool auto_notify_watcher;
+        bool compiled_matcher;
+        bool matcher_reordering;
+        bool arena_allocator;
+        // allocation_totals adds up the allocations of the JavaScript heaps when an evaluation context is released.
+        AllocationTotals allocation_totals;
 
         // enforce use a custom matcher to decides whether a "subject" can access a "object" with the operation "action", input parameters are usually: (matcher, sub, obj, act), use model matcher by default when matcher is "".
+        // When candidates_matcher is not NULL, only the rules that can satisfy its equality conjuncts for the request values r_vals are evaluated.
+        bool enforce(string matcher, FunctionMap& fm, EvaluationContext& context, shared_ptr<Matcher> candidates_matcher = NULL, const vector<string>* r_vals = NULL);
+
+        // enforce use a custom matcher to decides whether a "subject" can access a "object" with the operation "action", the request is read from a scope created by the caller.
         bool enforce(string matcher, Scope scope);
 
+        // enforce evaluates a native matcher against the request values, without the JavaScript engine.
+        bool enforce(shared_ptr<Matcher> matcher, const vector<string>& r_vals, EvaluationContext& context);
+
+        // AcquireContext checks out an evaluation context for a request, a new one is prepared with the functions,
+        // the compiled model matcher and the effect stream when none is idle. It is returned with ReleaseContext().
+        shared_ptr<EvaluationContext> AcquireContext();
+
+        // ReleaseContext ends the request of a context, adds up its allocations and returns it to the pool.
+        void ReleaseContext(shared_ptr<EvaluationContext> context);
+
+        // PublishLoadedPolicy builds the role links of the rules that have been loaded, then publishes the rules and the links
+        // one right after the other. If the links cannot be built, the current rules and links are kept.
+        void PublishLoadedPolicy();
+
+        // CandidateRules returns the positions of the rules that can satisfy the equality conjuncts of the matcher for the request,
+        // using the smallest list of matching rules of the column indices. It returns every rule when they have to be evaluated.
+        // The rules that have been removed but are still stored in the snapshot can be among them.
+        RuleList CandidateRules(const PolicyView& policy, shared_ptr<Matcher> matcher, const vector<int>& r_symbols);
+
+        // BindMatcher parses a matcher expression and binds it to the current model and functions.
+        shared_ptr<Matcher> BindMatcher(string expression);
+
+        // LoadMatcher prepares the model matcher once: it is parsed for native evaluation, and the g functions are bound to
+        // the role managers of their assertions, so that the matcher is not rewritten for every request.
+        void LoadMatcher();
+
     public:
 
         shared_ptr<RoleManager> rm;
@@ -151,6 +193,17 @@ class Enforcer : public Php::Base, public IEnforcer{
         void EnableAutoSave(bool auto_save);
         // EnableAutoBuildRoleLinks controls whether to rebuild the role inheritance relations when a role is added or deleted.
         void EnableAutoBuildRoleLinks(bool auto_build_role_links);
+        // EnableCompiledMatcher controls whether a matcher evaluated by the JavaScript engine is compiled once into a function instead of being evaluated from source for every policy rule.
+        void EnableCompiledMatcher(bool compiled_matcher);
+        // EnableMatcherReordering controls whether the operands of && and || in a natively evaluated matcher are reordered by estimated cost and selectivity.
+        void EnableMatcherReordering(bool matcher_reordering);
+        // GetMatcherShortCircuitCounts returns, for every operand of && and || in the model matcher, how often it decided the result on its own.
+        vector<pair<string, unsigned long long>> GetMatcherShortCircuitCounts();
+        // EnableArenaAllocator controls whether the JavaScript heaps allocate the temporaries of a request from an arena that is reset after the request.
+        void EnableArenaAllocator(bool arena_allocator);
+        // GetAllocationCounts returns the number of requests evaluated and the allocations their JavaScript heaps made,
+        // divided by the requests they give the allocations per enforce call.
+        AllocationCounts GetAllocationCounts();
         // BuildRoleLinks manually rebuild the role inheritance relations.
         void BuildRoleLinks();
         // BuildIncrementalRoleLinks provides incremental build the role inheritance relations.
@@ -190,20 +243,28 @@ class Enforcer : public Php::Base, public IEnforcer{
         vector<string> GetAllNamedRoles(string p_type);
         Php::Value getAllNamedRoles(Php::Parameters &params);
         vector<vector<string>> GetPolicy();
+        PolicyView GetPolicyView();
         Php::Value getPolicy();
         vector<vector<string>> GetFilteredPolicy(int field_index, vector<string> field_values);
+        PolicyView GetFilteredPolicyView(int field_index, vector<string> field_values);
         Php::Value getFilteredPolicy(Php::Parameters &params);
         vector<vector<string>> GetNamedPolicy(string p_type);
+        PolicyView GetNamedPolicyView(string p_type);
         Php::Value getNamedPolicy(Php::Parameters &params);
         vector<vector<string>> GetFilteredNamedPolicy(string p_type, int field_index, vector<string> field_values);
+        PolicyView GetFilteredNamedPolicyView(string p_type, int field_index, vector<string> field_values);
         Php::Value getFilteredNamedPolicy(Php::Parameters &params);
         vector<vector<string>> GetGroupingPolicy();
+        PolicyView GetGroupingPolicyView();
         Php::Value getGroupingPolicy();
         vector<vector<string>> GetFilteredGroupingPolicy(int field_index, vector<string> field_values);
+        PolicyView GetFilteredGroupingPolicyView(int field_index, vector<string> field_values);
         Php::Value getFilteredGroupingPolicy(Php::Parameters &params);
         vector<vector<string>> GetNamedGroupingPolicy(string p_type);
+        PolicyView GetNamedGroupingPolicyView(string p_type);
         Php::Value getNamedGroupingPolicy(Php::Parameters &params);
         vector<vector<string>> GetFilteredNamedGroupingPolicy(string p_type, int field_index, vector<string> field_values);
+        PolicyView GetFilteredNamedGroupingPolicyView(string p_type, int field_index, vector<string> field_values);
         Php::Value getFilteredNamedGroupingPolicy(Php::Parameters &params);
         bool HasPolicy(vector<string> params);
         Php::Value hasPolicy(Php::Parameters &params);
@@ -54,6 +54,9 @@ class IEnforcer {
         virtual void EnableAutoNotifyWatcher(bool enable) = 0;
         virtual void EnableAutoSave(bool auto_save) = 0;
         virtual void EnableAutoBuildRoleLinks(bool auto_build_role_links) = 0;
+        virtual void EnableCompiledMatcher(bool compiled_matcher) = 0;
+        virtual void EnableMatcherReordering(bool matcher_reordering) = 0;
+        virtual void EnableArenaAllocator(bool arena_allocator) = 0;
         virtual void BuildRoleLinks() = 0;
         virtual bool enforce(string matcher, Scope scope) = 0;
         virtual bool Enforce(Scope scope) = 0;
@@ -89,13 +92,21 @@ class IEnforcer {
         virtual vector<string> GetAllRoles() = 0;
         virtual vector<string> GetAllNamedRoles(string p_type) = 0;
         virtual vector<vector<string>> GetPolicy() = 0;
+        virtual PolicyView GetPolicyView() = 0;
         virtual vector<vector<string>> GetFilteredPolicy(int field_index, vector<string> field_values) = 0;
+        virtual PolicyView GetFilteredPolicyView(int field_index, vector<string> field_values) = 0;
         virtual vector<vector<string>> GetNamedPolicy(string p_type) = 0;
+        virtual PolicyView GetNamedPolicyView(string p_type) = 0;
         virtual vector<vector<string>> GetFilteredNamedPolicy(string p_type, int field_index, vector<string> field_values) = 0;
+        virtual PolicyView GetFilteredNamedPolicyView(string p_type, int field_index, vector<string> field_values) = 0;
         virtual vector<vector<string>> GetGroupingPolicy() = 0;
+        virtual PolicyView GetGroupingPolicyView() = 0;
         virtual vector<vector<string>> GetFilteredGroupingPolicy(int field_index, vector<string> field_values) = 0;
+        virtual PolicyView GetFilteredGroupingPolicyView(int field_index, vector<string> field_values) = 0;
         virtual vector<vector<string>> GetNamedGroupingPolicy(string p_type) = 0;
+        virtual PolicyView GetNamedGroupingPolicyView(string p_type) = 0;
         virtual vector<vector<string>> GetFilteredNamedGroupingPolicy(string p_type, int field_index, vector<string> field_values) = 0;
+        virtual PolicyView GetFilteredNamedGroupingPolicyView(string p_type, int field_index, vector<string> field_values) = 0;
         virtual bool HasPolicy(vector<string> params) = 0;
         virtual bool HasNamedPolicy(string p_type, vector<string> params) = 0;
         virtual bool AddPolicy(vector<string> params) = 0;
@@ -111,12 +111,12 @@ bool Enforcer :: RemovePolicy(string sec, string p_type, vector<string> rule) {
 
 // removePolicies removes rules from the current policy.
 bool Enforcer :: RemovePolicies(string sec, string p_type, vector<vector<string>> rules) {
-    bool rules_removed = this->model->AddPolicies(sec, p_type, rules);
+    bool rules_removed = this->model->RemovePolicies(sec, p_type, rules);
     if (!rules_removed)
         return rules_removed;
 
     if (sec == "g")
-        this->BuildIncrementalRoleLinks(policy_add, p_type, rules);
+        this->BuildIncrementalRoleLinks(policy_remove, p_type, rules);
 
     // if (this->adapter && this->auto_save) {
     //     try{
@@ -100,7 +100,12 @@ Php::Value Enforcer :: getAllNamedRoles(Php::Parameters &params) {
 
 // GetPolicy gets all the authorization rules in the policy.
 vector<vector<string>> Enforcer :: GetPolicy() {
-    return this->GetNamedPolicy("p");
+    return this->GetPolicyView().Values();
+}
+
+// GetPolicyView gets a read-only snapshot of all the authorization rules in the policy, the rules are not copied.
+PolicyView Enforcer :: GetPolicyView() {
+    return this->GetNamedPolicyView("p");
 }
 // PHPCPP
 Php::Value Enforcer :: getPolicy() {
@@ -109,7 +114,12 @@ Php::Value Enforcer :: getPolicy() {
 
 // GetFilteredPolicy gets all the authorization rules in the policy, field filters can be specified.
 vector<vector<string>> Enforcer :: GetFilteredPolicy(int field_index, vector<string> field_values) {
-    return this->GetFilteredNamedPolicy("p", field_index, field_values);
+    return this->GetFilteredPolicyView(field_index, field_values).Values();
+}
+
+// GetFilteredPolicyView gets a read-only snapshot of the authorization rules in the policy, field filters can be specified.
+PolicyView Enforcer :: GetFilteredPolicyView(int field_index, vector<string> field_values) {
+    return this->GetFilteredNamedPolicyView("p", field_index, field_values);
 }
 // PHPCPP
 Php::Value Enforcer :: getFilteredPolicy(Php::Parameters &params) {
@@ -120,7 +130,12 @@ Php::Value Enforcer :: getFilteredPolicy(Php::Parameters &params) {
 
 // GetNamedPolicy gets all the authorization rules in the named policy.
 vector<vector<string>> Enforcer :: GetNamedPolicy(string p_type) {
-    return this->model->GetPolicy("p", p_type);
+    return this->GetNamedPolicyView(p_type).Values();
+}
+
+// GetNamedPolicyView gets a read-only snapshot of all the authorization rules in the named policy.
+PolicyView Enforcer :: GetNamedPolicyView(string p_type) {
+    return this->model->GetPolicyView("p", p_type);
 }
 // PHPCPP
 Php::Value Enforcer :: getNamedPolicy(Php::Parameters &params) {
@@ -130,7 +145,12 @@ Php::Value Enforcer :: getNamedPolicy(Php::Parameters &params) {
 
 // GetFilteredNamedPolicy gets all the authorization rules in the named policy, field filters can be specified.
 vector<vector<string>> Enforcer :: GetFilteredNamedPolicy(string p_type, int field_index, vector<string> field_values) {
-    return this->model->GetFilteredPolicy("p", p_type, field_index, field_values);
+    return this->GetFilteredNamedPolicyView(p_type, field_index, field_values).Values();
+}
+
+// GetFilteredNamedPolicyView gets a read-only snapshot of the authorization rules in the named policy, field filters can be specified.
+PolicyView Enforcer :: GetFilteredNamedPolicyView(string p_type, int field_index, vector<string> field_values) {
+    return this->model->GetFilteredPolicyView("p", p_type, field_index, field_values);
 }
 // PHPCPP
 Php::Value Enforcer :: getFilteredNamedPolicy(Php::Parameters &params) {
@@ -142,7 +162,12 @@ Php::Value Enforcer :: getFilteredNamedPolicy(Php::Parameters &params) {
 
 // GetGroupingPolicy gets all the role inheritance rules in the policy.
 vector<vector<string>> Enforcer :: GetGroupingPolicy() {
-    return this->GetNamedGroupingPolicy("g");
+    return this->GetGroupingPolicyView().Values();
+}
+
+// GetGroupingPolicyView gets a read-only snapshot of all the role inheritance rules in the policy.
+PolicyView Enforcer :: GetGroupingPolicyView() {
+    return this->GetNamedGroupingPolicyView("g");
 }
 // PHPCPP
 Php::Value Enforcer :: getGroupingPolicy() {
@@ -151,7 +176,12 @@ Php::Value Enforcer :: getGroupingPolicy() {
 
 // GetFilteredGroupingPolicy gets all the role inheritance rules in the policy, field filters can be specified.
 vector<vector<string>> Enforcer :: GetFilteredGroupingPolicy(int field_index, vector<string> field_values) {
-    return this->GetFilteredNamedGroupingPolicy("g", field_index, field_values);
+    return this->GetFilteredGroupingPolicyView(field_index, field_values).Values();
+}
+
+// GetFilteredGroupingPolicyView gets a read-only snapshot of the role inheritance rules in the policy, field filters can be specified.
+PolicyView Enforcer :: GetFilteredGroupingPolicyView(int field_index, vector<string> field_values) {
+    return this->GetFilteredNamedGroupingPolicyView("g", field_index, field_values);
 }
 // PHPCPP
 Php::Value Enforcer :: getFilteredGroupingPolicy(Php::Parameters &params) {
@@ -162,7 +192,12 @@ Php::Value Enforcer :: getFilteredGroupingPolicy(Php::Parameters &params) {
 
 // GetNamedGroupingPolicy gets all the role inheritance rules in the policy.
 vector<vector<string>> Enforcer :: GetNamedGroupingPolicy(string p_type) {
-    return this->model->GetPolicy("g", p_type);
+    return this->GetNamedGroupingPolicyView(p_type).Values();
+}
+
+// GetNamedGroupingPolicyView gets a read-only snapshot of all the role inheritance rules in the policy.
+PolicyView Enforcer :: GetNamedGroupingPolicyView(string p_type) {
+    return this->model->GetPolicyView("g", p_type);
 }
 // PHPCPP
 Php::Value Enforcer :: getNamedGroupingPolicy(Php::Parameters &params) {
@@ -172,7 +207,12 @@ Php::Value Enforcer :: getNamedGroupingPolicy(Php::Parameters &params) {
 
 // GetFilteredNamedGroupingPolicy gets all the role inheritance rules in the policy, field filters can be specified.
 vector<vector<string>> Enforcer :: GetFilteredNamedGroupingPolicy(string p_type, int field_index, vector<string> field_values) {
-    return this->model->GetFilteredPolicy("g", p_type, field_index, field_values);
+    return this->GetFilteredNamedGroupingPolicyView(p_type, field_index, field_values).Values();
+}
+
+// GetFilteredNamedGroupingPolicyView gets a read-only snapshot of the role inheritance rules in the policy, field filters can be specified.
+PolicyView Enforcer :: GetFilteredNamedGroupingPolicyView(string p_type, int field_index, vector<string> field_values) {
+    return this->model->GetFilteredPolicyView("g", p_type, field_index, field_values);
 }
 // PHPCPP
 Php::Value Enforcer :: getFilteredNamedGroupingPolicy(Php::Parameters &params) {
@@ -498,6 +538,7 @@ Php::Value Enforcer :: removeFilteredNamedGroupingPolicy(Php::Parameters &params
 // AddFunction adds a customized function.
 void Enforcer :: AddFunction(string name, Function function, Index nargs) {
     this->func_map.AddFunction(name, function, nargs);
+    this->LoadMatcher();
 }
 // PHPCPP
 // TODO: class Function
@@ -19,6 +19,8 @@
 
 #include "./model/assertion.h"
 #include "./model/function.h"
+#include "./model/matcher.h"
+#include "./model/evaluation_context.h"
 #include "./model/model.h"
 #include "./model/scope_config.h"
 
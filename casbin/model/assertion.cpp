@@ -23,13 +23,200 @@
 #include "./assertion.h"
 #include "../exception/illegal_argument_exception.h"
 
+Assertion :: Assertion() {
+    this->snapshot = shared_ptr<PolicySnapshot>(new PolicySnapshot(0, shared_ptr<SymbolTable>(new SymbolTable())));
+}
+
+// Draft returns the unpublished version of the policy for a change, it is copied from the published one on the first change.
+PolicySnapshot& Assertion :: Draft() {
+    if(this->draft == NULL)
+        this->draft = shared_ptr<PolicySnapshot>(new PolicySnapshot(*atomic_load(&this->snapshot)));
+    return *this->draft;
+}
+
+// Current returns the version of the policy the writer sees, the draft if there is one.
+const PolicySnapshot& Assertion :: Current() {
+    if(this->draft != NULL)
+        return *this->draft;
+    return *atomic_load(&this->snapshot);
+}
+
+// Publish makes the changes of the policy visible to the readers, the snapshot they hold is freed when the last of them releases it.
+// The removed rules stay stored, and are skipped by the readers, until they are a quarter of the rules: then the draft is compacted
+// before it is published, so each compaction, which takes time in the number of rules, is paid for by as many removals.
+// If most symbols of the table are of values no rule has any more, the rules are interned in a new table instead.
+void Assertion :: Publish() {
+    if(this->draft == NULL)
+        return;
+
+    if(this->draft->RemovedCount() * 4 > this->draft->Rules().Size()) {
+        if(this->draft->Symbols()->Size() > 2 * this->draft->UsedSymbolCount())
+            this->draft = this->draft->Reintern();
+        else
+            this->draft->Compact();
+    }
+
+    atomic_store(&this->snapshot, shared_ptr<PolicySnapshot>(this->draft));
+    this->draft.reset();
+}
+
+// Discard drops the changes of the policy that have not been published.
+void Assertion :: Discard() {
+    if(this->draft == NULL)
+        return;
+    this->draft.reset();
+}
+
+// View returns the published snapshot of the policy, it is not affected by later changes of the policy.
+PolicyView Assertion :: View() {
+    return PolicyView(atomic_load(&this->snapshot));
+}
+
+// RuleCount returns the number of rules in the published policy.
+int Assertion :: RuleCount() {
+    shared_ptr<PolicySnapshot> snapshot = atomic_load(&this->snapshot);
+    return snapshot->Rules().Size() - snapshot->RemovedCount();
+}
+
+// AddRule appends a rule to the draft of the policy.
+void Assertion :: AddRule(const vector<string>& rule) {
+    PolicySnapshot& policy = this->Draft();
+    policy.Append(policy.Symbols()->InternAll(rule));
+}
+
+// HasRule determines whether a rule with the same values as rule, in any order, is in the published policy.
+// The rules are counted by the snapshot, so a policy that is being loaded in a draft does not hide them.
+bool Assertion :: HasRule(const vector<string>& rule) {
+    shared_ptr<PolicySnapshot> snapshot = atomic_load(&this->snapshot);
+    vector<int> symbols;
+    if(!snapshot->Symbols()->FindAll(rule, symbols))
+        return false;
+
+    return snapshot->CountRule(symbols) > 0;
+}
+
+// RemoveRule removes the i-th rule from the draft of the policy, the other rules keep their positions until it is published.
+void Assertion :: RemoveRule(int i) {
+    this->RemoveRules(vector<int>(1, i));
+}
+
+// RemoveRules removes the rules at the positions in indices from the draft of the policy, the other rules keep their positions until it is published.
+// The rules are only marked as removed, Publish drops all of them in one pass.
+void Assertion :: RemoveRules(const vector<int>& indices) {
+    if(indices.empty())
+        return;
+
+    PolicySnapshot& policy = this->Draft();
+    for(int k = 0 ; k < indices.size() ; k++)
+        policy.Remove(indices[k]);
+}
+
+// SetRules replaces the rules of the draft of the policy, the rules hold symbols of the symbol table of the current version of the policy.
+void Assertion :: SetRules(const vector<vector<int>>& rules) {
+    this->draft = shared_ptr<PolicySnapshot>(new PolicySnapshot(int(this->tokens.size()), this->Current().Symbols()));
+    for(int i = 0 ; i < rules.size() ; i++)
+        this->draft->Append(rules[i]);
+}
+
+// ClearRules removes all rules from the draft of the policy, the rules added next, e.g. when the policy is loaded again,
+// are interned in a new symbol table, so the values of the old rules are freed once no reader holds them.
+void Assertion :: ClearRules() {
+    this->draft = shared_ptr<PolicySnapshot>(new PolicySnapshot(int(this->tokens.size()), shared_ptr<SymbolTable>(new SymbolTable())));
+}
+
+// GetRule returns the values of the i-th rule of the current version of the policy.
+vector<string> Assertion :: GetRule(int i) {
+    const PolicySnapshot& policy = this->Current();
+    return policy.Symbols()->ValuesOf(policy.Rules().Rule(i));
+}
+
+// SameValues determines whether the i-th rule has the symbols of rule in any order, without copying the rule.
+static bool SameValues(const PolicyColumns& rules, int i, const vector<int>& rule) {
+    if(rules.RuleSize(i) != rule.size())
+        return false;
+
+    for(int j = 0 ; j < rule.size() ; j++){
+        int in_rule = 0;
+        int in_policy = 0;
+        for(int k = 0 ; k < rule.size() ; k++){
+            in_rule += rule[k] == rule[j];
+            in_policy += rules.At(i, k) == rule[j];
+        }
+        if(in_rule != in_policy)
+            return false;
+    }
+    return true;
+}
+
+// FindRule returns the index of the first rule of the current version of the policy with the same values as rule, in any order, or -1 if there is none.
+// A rule with the same values has the first value in some column, so it is looked up in the column indices of the policy
+// instead of scanning the rules, whatever the number of tokens of the assertion.
+int Assertion :: FindRule(const vector<string>& rule) {
+    const PolicySnapshot& policy = this->Current();
+    vector<int> symbols;
+    if(!policy.Symbols()->FindAll(rule, symbols))
+        return -1;
+
+    const PolicyColumns& rules = policy.Rules();
+    int count = policy.CountRule(symbols);
+    if(count == 0)
+        return -1;
+
+    if(symbols.empty()) {
+        for(int i = 0 ; i < rules.Size() ; i++){
+            if(!policy.IsRemoved(i) && rules.RuleSize(i) == 0)
+                return i;
+        }
+        return -1;
+    }
+
+    // Every index lists the rules in policy order, so only its first match before the one found so far matters.
+    // If a single rule has these values, the first match is the rule, and it is most likely in the first column.
+    int found = -1;
+    for(int j = 0 ; j < symbols.size() && (found == -1 || count > 1) ; j++){
+        RuleList candidates = policy.GetRulesWithSymbol(j, symbols[0]);
+        for(RuleList :: Iterator it = candidates.begin() ; it != candidates.end() ; ++it){
+            int i = *it;
+            if(found != -1 && i >= found)
+                break;
+            if(!policy.IsRemoved(i) && SameValues(rules, i, symbols)) {
+                found = i;
+                break;
+            }
+        }
+    }
+
+    return found;
+}
+
+// DistinctValues returns the values of the rules in a column of the published policy, each value once in the order it was first added.
+// The distinct symbols of every column are kept up to date by the policy, so the rules are not scanned.
+vector<string> Assertion :: DistinctValues(int column) {
+    shared_ptr<PolicySnapshot> snapshot = atomic_load(&this->snapshot);
+    return snapshot->Symbols()->ValuesOf(snapshot->DistinctValues(column));
+}
+
+// BuildIncrementalRoleLinks changes the links of rm for the rules. The role manager the g function of the assertion reads
+// is bound by the enforcer, it is not replaced here because requests read it without locks.
 void Assertion :: BuildIncrementalRoleLinks(shared_ptr<RoleManager> rm, policy_op op, vector<vector<string>> rules) {
-    this->rm = rm;
     int char_count = int(count(this->value.begin(), this->value.end(), '_'));
 
     if (char_count < 2)
         throw IllegalArgumentException("the number of \"_\" in role definition should be at least 2");
 
+    // The links of the rules are changed in one batch, so enforce calls see all of them or none.
+    rm->BeginUpdate();
+    try {
+        this->UpdateRoleLinks(rm.get(), op, rules, char_count);
+    } catch (...) {
+        // The links of the rules before the failing one are dropped with the batch.
+        rm->CancelUpdate();
+        throw;
+    }
+    rm->EndUpdate();
+}
+
+void Assertion :: UpdateRoleLinks(RoleManager* rm, policy_op op, const vector<vector<string>>& rules, int char_count) {
     for(int i = 0 ; i < rules.size() ; i++){
         vector<string> rule = rules[i];
 
@@ -42,33 +229,25 @@ void Assertion :: BuildIncrementalRoleLinks(shared_ptr<RoleManager> rm, policy_o
 
         switch(op) {
             case policy_op :: policy_add:
-                this->rm->AddLink(rule[0], rule[1], domain);
+                rm->AddLink(rule[0], rule[1], domain);
                 break;
             case policy_op :: policy_remove:
-                this->rm->DeleteLink(rule[0], rule[1], domain);
+                rm->DeleteLink(rule[0], rule[1], domain);
         }
     }
 }
 
 void Assertion :: BuildRoleLinks(shared_ptr<RoleManager> rm) {
-    this->rm = rm;
-    int char_count = int(count(this->value.begin(), this->value.end(), '_'));
-
-    if (char_count < 2)
-        throw IllegalArgumentException("the number of \"_\" in role definition should be at least 2");
-
-    for(int i = 0 ; i < this->policy.size() ; i++){
-        vector<string> rule = policy[i];
-
-        if (rule.size() < char_count)
-            throw IllegalArgumentException("grouping policy elements do not meet role definition");
-        if (rule.size() > char_count)
-            rule = vector<string>(rule.begin(), rule.begin() + char_count);
-
-        vector<string> domain(rule.begin() + 2, rule.end());
-        this->rm->AddLink(rule[0], rule[1], domain);
+    const PolicySnapshot& policy = this->Current();
+    vector<vector<string>> rules;
+    rules.reserve(policy.Rules().Size() - policy.RemovedCount());
+    for(int i = 0 ; i < policy.Rules().Size() ; i++){
+        if(!policy.IsRemoved(i))
+            rules.push_back(this->GetRule(i));
     }
 
+    this->BuildIncrementalRoleLinks(rm, policy_op :: policy_add, rules);
+
     // DefaultLogger df_logger;
     // df_logger.EnableLog(true);
 
@@ -19,6 +19,8 @@
 
 #include <memory>
 
+#include "./policy_view.h"
+#include "./symbol_table.h"
 #include "../rbac/role_manager.h"
 
 enum policy_op{
@@ -30,14 +32,71 @@ typedef enum policy_op policy_op;
 // Assertion represents an expression in a section of the model.
 // For example: r = sub, obj, act
 class Assertion {
+    private:
+
+        // snapshot is the published version of the policy, it is read and replaced with atomic operations,
+        // draft is the version a writer changes until it is published, NULL if there are no changes.
+        shared_ptr<PolicySnapshot> snapshot;
+        shared_ptr<PolicySnapshot> draft;
+
+        PolicySnapshot& Draft();
+
+        const PolicySnapshot& Current();
+
+        void UpdateRoleLinks(RoleManager* rm, policy_op op, const vector<vector<string>>& rules, int char_count);
+
     public:
 
         string key;
         string value;
         vector<string> tokens;
-        vector<vector<string>> policy;
+        // rm is the role manager the g function of the assertion reads, the enforcer binds it when it loads the matcher.
         shared_ptr<RoleManager> rm;
 
+        Assertion();
+
+        // View returns the published snapshot of the policy, it is not affected by later changes of the policy.
+        PolicyView View();
+
+        // RuleCount returns the number of rules in the published policy.
+        int RuleCount();
+
+        // Publish makes the changes of the policy visible to the readers, the snapshot they hold is freed when the last of them releases it.
+        // The rules are changed by one writer at a time, the changes go to a draft of the policy until they are published.
+        // The removed rules stay stored until they are a quarter of the rules, the readers skip them.
+        // The values of the rules are interned in a symbol table that is published with them.
+        void Publish();
+
+        // Discard drops the changes of the policy that have not been published.
+        void Discard();
+
+        // AddRule appends a rule to the draft of the policy.
+        void AddRule(const vector<string>& rule);
+
+        // GetRule returns the values of the i-th rule of the current version of the policy.
+        vector<string> GetRule(int i);
+
+        // HasRule determines whether a rule with the same values as rule, in any order, is in the published policy.
+        bool HasRule(const vector<string>& rule);
+
+        // FindRule returns the index of the first rule of the current version of the policy with the same values as rule, in any order, or -1 if there is none.
+        int FindRule(const vector<string>& rule);
+
+        // RemoveRule removes the i-th rule from the draft of the policy, the other rules keep their positions until it is published.
+        void RemoveRule(int i);
+
+        // RemoveRules removes the rules at the positions in indices from the draft of the policy, the other rules keep their positions until it is published.
+        void RemoveRules(const vector<int>& indices);
+
+        // SetRules replaces the rules of the draft of the policy, the rules hold symbols of the symbol table of the current version of the policy.
+        void SetRules(const vector<vector<int>>& rules);
+
+        // ClearRules removes all rules from the draft of the policy, the rules added next are interned in a new symbol table.
+        void ClearRules();
+
+        // DistinctValues returns the values of the rules in a column of the published policy, each value once in the order it was first added.
+        vector<string> DistinctValues(int column);
+
         void BuildIncrementalRoleLinks(shared_ptr<RoleManager> rm, policy_op op, vector<vector<string>> rules);
 
         void BuildRoleLinks(shared_ptr<RoleManager> rm);
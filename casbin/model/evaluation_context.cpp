@@ -0,0 +1,112 @@
+/*
+* Copyright 2020 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#pragma once
+
+#include "pch.h"
+
+#include "./evaluation_context.h"
+
+// EvaluationContext creates a context with its own heap, loaded with the functions of func_map.
+// The heap allocates the temporaries of a request from an arena if arena_allocator is true.
+EvaluationContext :: EvaluationContext(const FunctionMap& func_map, bool arena_allocator) : arena(new HeapArena(arena_allocator)), func_map(func_map, arena->NewScope()) {
+    this->generation = 0;
+}
+
+thread_local EvaluationContextPool :: ThreadContext EvaluationContextPool :: thread_context;
+
+EvaluationContextPool :: ThreadContext :: ThreadContext() {
+    this->slot = NULL;
+}
+
+EvaluationContextPool :: ThreadContext :: ~ThreadContext() {
+    shared_ptr<State> owner = this->owner.lock();
+    if (owner == NULL)
+        return;
+
+    lock_guard<mutex> guard(owner->lock);
+    for (vector<shared_ptr<Slot>> :: iterator it = owner->slots.begin() ; it != owner->slots.end() ; it++) {
+        if (it->get() == this->slot) {
+            owner->slots.erase(it);
+            break;
+        }
+    }
+}
+
+EvaluationContextPool :: EvaluationContextPool() {
+    this->state = shared_ptr<State>(new State());
+    this->state->generation = 0;
+}
+
+// Acquire checks out a context of the current generation, it returns NULL when the caller has to create one.
+shared_ptr<EvaluationContext> EvaluationContextPool :: Acquire() {
+    unsigned long generation = this->state->generation;
+
+    // The pool cannot be destroyed while its slot is used, the thread holds a reference to it.
+    shared_ptr<State> owner = thread_context.owner.lock();
+    if (owner == this->state && thread_context.slot->context != NULL) {
+        shared_ptr<EvaluationContext> context = thread_context.slot->context;
+        thread_context.slot->context = NULL;
+        if (context->generation == generation)
+            return context;
+    }
+
+    lock_guard<mutex> guard(this->state->lock);
+    while (!this->state->idle.empty()) {
+        shared_ptr<EvaluationContext> context = this->state->idle.back();
+        this->state->idle.pop_back();
+        if (context->generation == generation)
+            return context;
+    }
+
+    return NULL;
+}
+
+// Release returns a context to the pool, contexts of an older generation are dropped.
+void EvaluationContextPool :: Release(shared_ptr<EvaluationContext> context) {
+    if (context->generation != this->state->generation)
+        return;
+
+    // The thread keeps the context unless it already keeps one of a pool that is still alive.
+    shared_ptr<State> owner = thread_context.owner.lock();
+    if (owner == this->state && thread_context.slot->context == NULL) {
+        thread_context.slot->context = context;
+        return;
+    }
+
+    lock_guard<mutex> guard(this->state->lock);
+    if (owner == NULL) {
+        shared_ptr<Slot> slot(new Slot());
+        slot->context = context;
+        this->state->slots.push_back(slot);
+        thread_context.owner = this->state;
+        thread_context.slot = slot.get();
+        return;
+    }
+
+    this->state->idle.push_back(context);
+}
+
+// Invalidate drops the idle contexts, e.g. after the functions or the model changed, and starts a new generation.
+void EvaluationContextPool :: Invalidate() {
+    lock_guard<mutex> guard(this->state->lock);
+    this->state->generation++;
+    this->state->idle.clear();
+}
+
+// Generation returns the generation new contexts have to be created for.
+unsigned long EvaluationContextPool :: Generation() {
+    return this->state->generation;
+}
@@ -0,0 +1,99 @@
+/*
+* Copyright 2020 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef CASBIN_CPP_MODEL_EVALUATION_CONTEXT
+#define CASBIN_CPP_MODEL_EVALUATION_CONTEXT
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "./function.h"
+#include "./heap_arena.h"
+#include "./matcher.h"
+#include "../effect/effector.h"
+
+using namespace std;
+
+// EvaluationContext holds everything a request needs to be evaluated that cannot be shared between threads:
+// the JavaScript heap with the functions and the compiled matcher, the effect stream and scratch space for the native matcher.
+class EvaluationContext {
+    public:
+        // arena provides the memory of the heap of func_map, so it is declared first and destroyed last.
+        shared_ptr<HeapArena> arena;
+        FunctionMap func_map;
+        shared_ptr<EffectorStream> effects;
+        vector<MatcherValue> invariants;
+        vector<int> request_symbols;
+        unsigned long generation;
+
+        // EvaluationContext creates a context with its own heap, loaded with the functions of func_map.
+        // The heap allocates the temporaries of a request from an arena if arena_allocator is true.
+        EvaluationContext(const FunctionMap& func_map, bool arena_allocator);
+};
+
+// EvaluationContextPool hands out evaluation contexts, so that one enforcer can serve requests from several threads.
+// Each thread keeps the context it used last, so a thread checks its context out again without taking the lock.
+class EvaluationContextPool {
+    private:
+        // Slot holds the context a thread keeps, it is owned by the pool so that the context is freed with the pool.
+        class Slot {
+            public:
+                shared_ptr<EvaluationContext> context;
+        };
+
+        class State {
+            public:
+                mutex lock;
+                vector<shared_ptr<EvaluationContext>> idle;
+                vector<shared_ptr<Slot>> slots;
+                atomic<unsigned long> generation;
+        };
+
+        // ThreadContext refers to the slot of the pool a thread used last, the slot is only used by that thread.
+        // The slot is removed from its pool when the thread exits.
+        class ThreadContext {
+            public:
+                weak_ptr<State> owner;
+                Slot* slot;
+
+                ThreadContext();
+
+                ~ThreadContext();
+        };
+
+        static thread_local ThreadContext thread_context;
+
+        shared_ptr<State> state;
+
+    public:
+
+        EvaluationContextPool();
+
+        // Acquire checks out a context of the current generation, it returns NULL when the caller has to create one.
+        shared_ptr<EvaluationContext> Acquire();
+
+        // Release returns a context to the pool, contexts of an older generation are dropped.
+        void Release(shared_ptr<EvaluationContext> context);
+
+        // Invalidate drops the idle contexts, e.g. after the functions or the model changed, and starts a new generation.
+        void Invalidate();
+
+        // Generation returns the generation new contexts have to be created for.
+        unsigned long Generation();
+};
+
+#endif
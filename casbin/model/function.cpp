@@ -21,35 +21,94 @@
 #include "./function.h"
 #include "../util/util.h"
 
+// FunctionMap creates a scope that lives as long as the function map, so it can be reused by every request.
 FunctionMap :: FunctionMap(){
     scope = InitializeScope();
+    owns_scope = true;
+    policy_object = NULL;
 }
 
-void FunctionMap :: ProcessFunctions(string expression){
-    for(unordered_map<string, Function> :: iterator it = this->func_map.begin() ; it != this->func_map.end() ; it++){
-        int index = int(expression.find((it->first)+"("));
-
-        if(index != string::npos){
-            int close_index = int(expression.find(")", index));
-            int start = index + int(((it->first)+"(").length());
-
-            string function_params = expression.substr(start, close_index-start);
-            FetchIdentifier(this->scope, it->first);
-            vector<string> params = Split(function_params, ",");
-
-            for(int i=0;i<params.size();i++){
-                int quote_index = int(params[i].find("\""));
-                if(quote_index == string::npos)
-                    Get(this->scope, Trim(params[i]));
-                else{
-                    params[i] = params[i].replace(quote_index, 1, "'");
-                    int second_quote_index = int(params[i].find("\"", quote_index+1));
-                    params[i] = params[i].replace(second_quote_index, 1, "'");
-                    Get(this->scope, Trim(params[i]));
-                }
-            }
+// FunctionMap evaluates in a scope owned by the caller, the scope is not destroyed with the function map.
+FunctionMap :: FunctionMap(Scope scope){
+    this->scope = scope;
+    owns_scope = false;
+    policy_object = NULL;
+}
+
+FunctionMap :: FunctionMap(const FunctionMap& other) : FunctionMap(other, InitializeScope()){
+}
+
+// FunctionMap takes ownership of scope and loads the functions of other into it.
+FunctionMap :: FunctionMap(const FunctionMap& other, Scope scope){
+    this->scope = scope;
+    owns_scope = true;
+    policy_object = NULL;
+    for(unordered_map<string, Function> :: const_iterator it = other.func_map.begin() ; it != other.func_map.end() ; it++)
+        AddFunction(it->first, it->second, other.func_nargs.at(it->first));
+    for(unordered_map<string, pair<shared_ptr<RoleManager>*, Index>> :: const_iterator it = other.g_func_map.begin() ; it != other.g_func_map.end() ; it++)
+        AddGFunction(it->first, it->second.first, it->second.second);
+}
+
+FunctionMap& FunctionMap :: operator=(const FunctionMap& other){
+    if(this == &other)
+        return *this;
+
+    if(owns_scope)
+        DestroyScope(scope);
+    scope = InitializeScope();
+    owns_scope = true;
+    compiled_expression = "";
+    policy_tokens.clear();
+    policy_object = NULL;
+    policy_keys.clear();
+    func_map.clear();
+    func_nargs.clear();
+    g_func_map.clear();
+    for(unordered_map<string, Function> :: const_iterator it = other.func_map.begin() ; it != other.func_map.end() ; it++)
+        AddFunction(it->first, it->second, other.func_nargs.at(it->first));
+    for(unordered_map<string, pair<shared_ptr<RoleManager>*, Index>> :: const_iterator it = other.g_func_map.begin() ; it != other.g_func_map.end() ; it++)
+        AddGFunction(it->first, it->second.first, it->second.second);
+
+    return *this;
+}
+
+FunctionMap :: ~FunctionMap(){
+    if(owns_scope)
+        DestroyScope(scope);
+}
+
+// ResetR replaces the request object "r" with an empty one, so that the scope can serve the next request.
+void FunctionMap :: ResetR(){
+    SetSize(scope, 0);
+    PushObject(scope, "r");
+}
+
+// PreparePolicy makes "p" an object with the property names of the policy tokens interned once, it is reused for every policy rule.
+void FunctionMap :: PreparePolicy(const vector<string>& tokens){
+    if(policy_object == NULL || policy_tokens != tokens){
+        policy_tokens = tokens;
+        policy_keys.clear();
+
+        PushNewObjectValue(scope);
+        policy_object = StashValue(scope, "p");
+        for(int i = 0 ; i < tokens.size() ; i++){
+            int index = int(tokens[i].find("_"));
+            string key = tokens[i].substr(index+1);
+            PushStringValue(scope, key);
+            policy_keys.push_back(StashValue(scope, "p." + key));
         }
     }
+
+    PushHeapPointer(scope, policy_object, "p");
+    PushInt(scope, int(policy_keys.size()), "plen");
+}
+
+// BindPolicy writes the values of a policy rule into the "p" object by position.
+void FunctionMap :: BindPolicy(const PolicyView :: Rule& rule){
+    policy_values.resize(rule.Size());
+    for(int i = 0 ; i < rule.Size() ; i++)
+        policy_values[i] = &rule[i];
+    PushStringPropsToHeapObject(scope, policy_object, policy_keys, policy_values);
 }
 
 int FunctionMap :: GetRLen(){
@@ -60,10 +119,28 @@ int FunctionMap :: GetRLen(){
 }
 
 bool FunctionMap :: Evaluate(string expression){
-    ProcessFunctions(expression);
     return Eval(scope, expression);
 }
 
+// CompileMatcher compiles the expression into a function of (r, p), it is compiled again only when the expression changes.
+bool FunctionMap :: CompileMatcher(const string& expression){
+    if(compiled_expression == expression)
+        return true;
+
+    compiled_expression = "";
+    if(!CompileFunction(scope, "function (r, p) { return (" + expression + "); }", "matcher"))
+        return false;
+    compiled_expression = expression;
+    return true;
+}
+
+// EvaluateCompiled calls the compiled matcher with the current "r" and "p" objects.
+bool FunctionMap :: EvaluateCompiled(){
+    FetchIdentifier(scope, "r");
+    FetchIdentifier(scope, "p");
+    return CallFunction(scope, "matcher", 2);
+}
+
 bool FunctionMap :: GetBooleanResult(){
     return bool(duk_get_boolean(scope, -1));
 }
@@ -71,9 +148,24 @@ bool FunctionMap :: GetBooleanResult(){
 // AddFunction adds an expression function.
 void FunctionMap :: AddFunction(string func_name, Function f, Index nargs) {
     func_map[func_name] = f;
+    func_nargs[func_name] = nargs;
     PushFunction(this->scope, f, func_name, nargs);
 }
 
+// AddGFunction adds the g function of a role definition, rm points to the role manager of the assertion,
+// so a role manager set after the function is added is used as well.
+void FunctionMap :: AddGFunction(string func_name, shared_ptr<RoleManager>* rm, Index nargs) {
+    g_func_map[func_name] = make_pair(rm, nargs);
+    PushBoundFunction(this->scope, GFunctionWithRoleManager, func_name, nargs, (void *)rm);
+}
+
+// ClearGFunctions removes the g functions of a previous model.
+void FunctionMap :: ClearGFunctions() {
+    for(unordered_map<string, pair<shared_ptr<RoleManager>*, Index>> :: iterator it = g_func_map.begin() ; it != g_func_map.end() ; it++)
+        PushUndefined(this->scope, it->first);
+    g_func_map.clear();
+}
+
 void FunctionMap :: AddFunctionPropToR(string identifier, Function func, Index nargs){
     PushFunctionPropToObject(scope, "r", func, identifier, nargs);
 }
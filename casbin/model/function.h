@@ -17,30 +17,76 @@
 #ifndef CASBIN_CPP_MODEL_FUNCTION
 #define CASBIN_CPP_MODEL_FUNCTION
 
+#include <memory>
 #include <unordered_map>
 
 #include "../util/built_in_functions.h"
+#include "./policy_view.h"
+#include "../rbac/role_manager.h"
 
 using namespace std;
 
 class FunctionMap {
+    private:
+        bool owns_scope;
+        string compiled_expression;
+        vector<string> policy_tokens;
+        HeapPointer policy_object;
+        vector<HeapPointer> policy_keys;
+        vector<const string*> policy_values;
+
     public:
         Scope scope;
         unordered_map <string, Function> func_map;
+        unordered_map <string, Index> func_nargs;
+        unordered_map <string, pair<shared_ptr<RoleManager>*, Index>> g_func_map;
 
+        // FunctionMap creates a scope that lives as long as the function map, so it can be reused by every request.
         FunctionMap();
 
-        void ProcessFunctions(string expression);
+        // FunctionMap evaluates in a scope owned by the caller, the scope is not destroyed with the function map.
+        FunctionMap(Scope scope);
+
+        FunctionMap(const FunctionMap& other);
+
+        // FunctionMap takes ownership of scope and loads the functions of other into it.
+        FunctionMap(const FunctionMap& other, Scope scope);
+
+        FunctionMap& operator=(const FunctionMap& other);
+
+        ~FunctionMap();
+
+        // ResetR replaces the request object "r" with an empty one, so that the scope can serve the next request.
+        void ResetR();
+
+        // PreparePolicy makes "p" an object with the property names of the policy tokens interned once, it is reused for every policy rule.
+        void PreparePolicy(const vector<string>& tokens);
+
+        // BindPolicy writes the values of a policy rule into the "p" object by position.
+        void BindPolicy(const PolicyView :: Rule& rule);
 
         int GetRLen();
 
         bool Evaluate(string expression);
 
+        // CompileMatcher compiles the expression into a function of (r, p), it is compiled again only when the expression changes.
+        bool CompileMatcher(const string& expression);
+
+        // EvaluateCompiled calls the compiled matcher with the current "r" and "p" objects.
+        bool EvaluateCompiled();
+
         bool GetBooleanResult();
 
         // AddFunction adds an expression function.
         void AddFunction(string func_name, Function f, Index nargs);
 
+        // AddGFunction adds the g function of a role definition, rm points to the role manager of the assertion,
+        // so a role manager set after the function is added is used as well.
+        void AddGFunction(string func_name, shared_ptr<RoleManager>* rm, Index nargs);
+
+        // ClearGFunctions removes the g functions of a previous model.
+        void ClearGFunctions();
+
         void AddFunctionPropToR(string identifier, Function func, Index nargs);
 
         void AddBooleanPropToR(string identifier, bool val);
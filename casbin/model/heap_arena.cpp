@@ -0,0 +1,258 @@
+/*
+* Copyright 2020 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "pch.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "./heap_arena.h"
+
+namespace {
+    // BlockHeader precedes every block, chunk is NULL for blocks of the system allocator.
+    // Its size keeps the blocks aligned for any type.
+    union BlockHeader {
+        struct {
+            void* chunk;
+            size_t size;
+        } block;
+        max_align_t align;
+    };
+
+    size_t Align(size_t size) {
+        return (size + sizeof(BlockHeader) - 1) / sizeof(BlockHeader) * sizeof(BlockHeader);
+    }
+
+    BlockHeader* HeaderOf(void* ptr) {
+        return (BlockHeader*)ptr - 1;
+    }
+}
+
+AllocationCounts :: AllocationCounts() {
+    this->requests = 0;
+    this->arena_allocations = 0;
+    this->system_allocations = 0;
+}
+
+AllocationTotals :: AllocationTotals() {
+    this->requests = 0;
+    this->arena_allocations = 0;
+    this->system_allocations = 0;
+}
+
+AllocationTotals :: AllocationTotals(const AllocationTotals& other) {
+    AllocationCounts counts = other.Counts();
+    this->requests = counts.requests;
+    this->arena_allocations = counts.arena_allocations;
+    this->system_allocations = counts.system_allocations;
+}
+
+void AllocationTotals :: Add(const AllocationCounts& counts) {
+    this->requests += counts.requests;
+    this->arena_allocations += counts.arena_allocations;
+    this->system_allocations += counts.system_allocations;
+}
+
+AllocationCounts AllocationTotals :: Counts() const {
+    AllocationCounts counts;
+    counts.requests = this->requests;
+    counts.arena_allocations = this->arena_allocations;
+    counts.system_allocations = this->system_allocations;
+    return counts;
+}
+
+// HeapArena creates an arena, when it is not enabled every allocation goes to the system allocator but is still counted.
+HeapArena :: HeapArena(bool enabled, size_t chunk_size) {
+    this->chunk_size = chunk_size;
+    this->enabled = enabled;
+    this->in_request = false;
+    this->current = NULL;
+    this->spare = NULL;
+}
+
+HeapArena :: ~HeapArena() {
+    for (int i = 0 ; i < this->chunks.size() ; i++) {
+        free(this->chunks[i]->base);
+        delete this->chunks[i];
+    }
+}
+
+// NewScope creates a heap that allocates from the arena, it has to be destroyed before the arena.
+Scope HeapArena :: NewScope() {
+    return duk_create_heap(AllocFunction, ReallocFunction, FreeFunction, this, NULL);
+}
+
+// BeginRequest starts counting and serving the allocations of a request from the arena.
+void HeapArena :: BeginRequest() {
+    this->in_request = true;
+    this->counts.requests++;
+}
+
+// EndRequest rewinds the current chunk if the request freed everything it allocated.
+void HeapArena :: EndRequest() {
+    this->in_request = false;
+    if (this->current != NULL && this->current->live == 0)
+        this->current->offset = 0;
+}
+
+// TakeCounts returns the allocations made during the requests since it was last called, and starts counting again.
+AllocationCounts HeapArena :: TakeCounts() {
+    AllocationCounts counts = this->counts;
+    this->counts = AllocationCounts();
+    return counts;
+}
+
+HeapArena :: Chunk* HeapArena :: NewChunk() {
+    if (this->spare != NULL) {
+        Chunk* chunk = this->spare;
+        this->spare = NULL;
+        return chunk;
+    }
+
+    Chunk* chunk = new Chunk();
+    chunk->base = (char*)malloc(this->chunk_size);
+    chunk->offset = 0;
+    chunk->capacity = this->chunk_size;
+    chunk->live = 0;
+    this->chunks.push_back(chunk);
+    return chunk;
+}
+
+void HeapArena :: DeleteChunk(Chunk* chunk) {
+    // One empty chunk is kept, so a request that fills the current chunk does not have to allocate a new one.
+    if (this->spare == NULL) {
+        chunk->offset = 0;
+        this->spare = chunk;
+        return;
+    }
+
+    for (int i = 0 ; i < this->chunks.size() ; i++) {
+        if (this->chunks[i] == chunk) {
+            this->chunks.erase(this->chunks.begin() + i);
+            break;
+        }
+    }
+    free(chunk->base);
+    delete chunk;
+}
+
+void* HeapArena :: Allocate(size_t size) {
+    size_t needed = sizeof(BlockHeader) + Align(size);
+
+    // Large blocks would waste most of a chunk, so they go to the system allocator like allocations outside a request.
+    if (!this->enabled || !this->in_request || needed > this->chunk_size / 8) {
+        BlockHeader* header = (BlockHeader*)malloc(sizeof(BlockHeader) + size);
+        if (header == NULL)
+            return NULL;
+        header->block.chunk = NULL;
+        header->block.size = size;
+        if (this->in_request)
+            this->counts.system_allocations++;
+        return header + 1;
+    }
+
+    if (this->current != NULL && this->current->live == 0)
+        this->current->offset = 0;
+    if (this->current == NULL || this->current->offset + needed > this->current->capacity) {
+        if (this->current != NULL && this->current->live == 0)
+            this->DeleteChunk(this->current);
+        this->current = this->NewChunk();
+        if (this->current->base == NULL)
+            return NULL;
+    }
+
+    BlockHeader* header = (BlockHeader*)(this->current->base + this->current->offset);
+    header->block.chunk = this->current;
+    header->block.size = size;
+    this->current->offset += needed;
+    this->current->live++;
+    this->counts.arena_allocations++;
+    return header + 1;
+}
+
+void* HeapArena :: Reallocate(void* ptr, size_t size) {
+    if (ptr == NULL)
+        return this->Allocate(size);
+    if (size == 0) {
+        this->Release(ptr);
+        return NULL;
+    }
+
+    BlockHeader* header = HeaderOf(ptr);
+
+    // Blocks of the system allocator stay there, they are usually long-lived, like the value stack.
+    if (header->block.chunk == NULL) {
+        header = (BlockHeader*)realloc(header, sizeof(BlockHeader) + size);
+        if (header == NULL)
+            return NULL;
+        header->block.size = size;
+        if (this->in_request)
+            this->counts.system_allocations++;
+        return header + 1;
+    }
+
+    if (size <= header->block.size) {
+        header->block.size = size;
+        return ptr;
+    }
+
+    // The last block of the current chunk grows in place.
+    Chunk* chunk = (Chunk*)header->block.chunk;
+    size_t end = (char*)ptr - chunk->base + Align(header->block.size);
+    size_t grown = (char*)ptr - chunk->base + Align(size);
+    if (chunk == this->current && end == chunk->offset && grown <= chunk->capacity) {
+        chunk->offset = grown;
+        header->block.size = size;
+        return ptr;
+    }
+
+    void* moved = this->Allocate(size);
+    if (moved == NULL)
+        return NULL;
+    memcpy(moved, ptr, header->block.size);
+    this->Release(ptr);
+    return moved;
+}
+
+void HeapArena :: Release(void* ptr) {
+    if (ptr == NULL)
+        return;
+
+    BlockHeader* header = HeaderOf(ptr);
+    if (header->block.chunk == NULL) {
+        free(header);
+        return;
+    }
+
+    Chunk* chunk = (Chunk*)header->block.chunk;
+    chunk->live--;
+    if (chunk->live == 0 && chunk != this->current)
+        this->DeleteChunk(chunk);
+}
+
+void* HeapArena :: AllocFunction(void* udata, duk_size_t size) {
+    return ((HeapArena*)udata)->Allocate(size);
+}
+
+void* HeapArena :: ReallocFunction(void* udata, void* ptr, duk_size_t size) {
+    return ((HeapArena*)udata)->Reallocate(ptr, size);
+}
+
+void HeapArena :: FreeFunction(void* udata, void* ptr) {
+    ((HeapArena*)udata)->Release(ptr);
+}
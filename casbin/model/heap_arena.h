@@ -0,0 +1,114 @@
+/*
+* Copyright 2020 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef CASBIN_CPP_MODEL_HEAP_ARENA
+#define CASBIN_CPP_MODEL_HEAP_ARENA
+
+#include <atomic>
+#include <vector>
+
+#include "./scope_config.h"
+
+using namespace std;
+
+// AllocationCounts counts the allocations made by the JavaScript heaps while requests were evaluated.
+class AllocationCounts {
+    public:
+        unsigned long long requests;
+        // arena_allocations are served from the arena, system_allocations go to the system allocator.
+        unsigned long long arena_allocations;
+        unsigned long long system_allocations;
+
+        AllocationCounts();
+};
+
+// AllocationTotals adds up the allocation counts of the requests evaluated by several threads.
+class AllocationTotals {
+    private:
+        atomic<unsigned long long> requests;
+        atomic<unsigned long long> arena_allocations;
+        atomic<unsigned long long> system_allocations;
+
+    public:
+
+        AllocationTotals();
+
+        AllocationTotals(const AllocationTotals& other);
+
+        void Add(const AllocationCounts& counts);
+
+        AllocationCounts Counts() const;
+};
+
+// HeapArena provides the memory of a JavaScript heap. While a request is evaluated, allocations are bumped
+// from large chunks, and a chunk is rewound as soon as every block in it has been freed, which is usually
+// at the end of the request. Allocations made outside a request, e.g. the built-in functions and the
+// compiled matcher, go to the system allocator, so long-lived objects do not pin a chunk.
+class HeapArena {
+    private:
+        class Chunk {
+            public:
+                char* base;
+                size_t offset;
+                size_t capacity;
+                size_t live;
+        };
+
+        size_t chunk_size;
+        bool enabled;
+        bool in_request;
+        Chunk* current;
+        Chunk* spare;
+        vector<Chunk*> chunks;
+        AllocationCounts counts;
+
+        void* Allocate(size_t size);
+
+        void* Reallocate(void* ptr, size_t size);
+
+        void Release(void* ptr);
+
+        Chunk* NewChunk();
+
+        void DeleteChunk(Chunk* chunk);
+
+        static void* AllocFunction(void* udata, duk_size_t size);
+
+        static void* ReallocFunction(void* udata, void* ptr, duk_size_t size);
+
+        static void FreeFunction(void* udata, void* ptr);
+
+    public:
+
+        // HeapArena creates an arena, when it is not enabled every allocation goes to the system allocator but is still counted.
+        HeapArena(bool enabled, size_t chunk_size = 64 * 1024);
+
+        ~HeapArena();
+
+        // NewScope creates a heap that allocates from the arena, it has to be destroyed before the arena.
+        Scope NewScope();
+
+        // BeginRequest starts counting and serving the allocations of a request from the arena.
+        void BeginRequest();
+
+        // EndRequest rewinds the current chunk if the request freed everything it allocated.
+        void EndRequest();
+
+        // TakeCounts returns the allocations made during the requests since it was last called, and starts counting again.
+        AllocationCounts TakeCounts();
+};
+
+#endif
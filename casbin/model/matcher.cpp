@@ -0,0 +1,1040 @@
+/*
+* Copyright 2020 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "pch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <locale>
+#include <sstream>
+
+#include "./matcher.h"
+#include "../util/built_in_functions.h"
+#include "../util/util.h"
+
+using namespace std;
+
+MatcherValue :: MatcherValue() {
+    this->kind = Kind :: Bool;
+    this->boolean = false;
+    this->number = 0;
+    this->str = NULL;
+    this->symbol = -1;
+}
+
+MatcherValue MatcherValue :: FromBool(bool b) {
+    MatcherValue value;
+    value.kind = Kind :: Bool;
+    value.boolean = b;
+    return value;
+}
+
+MatcherValue MatcherValue :: FromNumber(double n) {
+    MatcherValue value;
+    value.kind = Kind :: Number;
+    value.number = n;
+    return value;
+}
+
+MatcherValue MatcherValue :: FromString(const string* s) {
+    MatcherValue value;
+    value.kind = Kind :: String;
+    value.str = s;
+    return value;
+}
+
+MatcherValue MatcherValue :: FromSymbol(const string* s, int symbol) {
+    MatcherValue value;
+    value.kind = Kind :: String;
+    value.str = s;
+    value.symbol = symbol;
+    return value;
+}
+
+// Truthy converts the value to a boolean the same way JavaScript does.
+bool MatcherValue :: Truthy() const {
+    switch(this->kind) {
+        case Kind :: Bool:
+            return this->boolean;
+        case Kind :: Number:
+            return this->number != 0 && !std::isnan(this->number);
+        default:
+            return !this->str->empty();
+    }
+}
+
+// ToNumber converts the value to a number the same way JavaScript does.
+double MatcherValue :: ToNumber() const {
+    switch(this->kind) {
+        case Kind :: Bool:
+            return this->boolean ? 1 : 0;
+        case Kind :: Number:
+            return this->number;
+        default: {
+            string s = *(this->str);
+            s = Trim(s);
+            if (s.empty())
+                return 0;
+            char* end;
+            double n = strtod(s.c_str(), &end);
+            if (*end != '\0')
+                return NAN;
+            return n;
+        }
+    }
+}
+
+// Equals compares two values with the loose equality (==) of JavaScript.
+bool MatcherValue :: Equals(const MatcherValue& other) const {
+    if (this->kind == Kind :: String && other.kind == Kind :: String) {
+        if (this->symbol != -1 && other.symbol != -1)
+            return this->symbol == other.symbol;
+        return *(this->str) == *(other.str);
+    }
+    if (this->kind == Kind :: Bool && other.kind == Kind :: Bool)
+        return this->boolean == other.boolean;
+    return this->ToNumber() == other.ToNumber();
+}
+
+MatcherNode :: MatcherNode(Kind kind) {
+    this->kind = kind;
+    this->index = -1;
+    this->func = NULL;
+    this->invariant = false;
+    this->slot = -1;
+    this->short_circuits = 0;
+}
+
+/**
+ * MatcherParser is a recursive descent parser for the subset of JavaScript used by matchers:
+ * ==, !=, &&, ||, !, in, parentheses, string/number/boolean literals, r./p. accessors and function calls.
+ */
+class MatcherParser {
+    private:
+
+        string s;
+        size_t pos;
+        bool ok;
+
+        void SkipSpaces() {
+            while (this->pos < this->s.length() && isspace((unsigned char)this->s[this->pos]))
+                this->pos++;
+        }
+
+        bool Peek(string op) {
+            this->SkipSpaces();
+            return !this->s.compare(this->pos, op.length(), op);
+        }
+
+        bool Accept(string op) {
+            if (!this->Peek(op))
+                return false;
+            this->pos += op.length();
+            return true;
+        }
+
+        bool IsIdentStart(char c) {
+            return isalpha((unsigned char)c) || c == '_' || c == '$';
+        }
+
+        bool IsIdentPart(char c) {
+            return isalnum((unsigned char)c) || c == '_' || c == '$';
+        }
+
+        string Identifier() {
+            this->SkipSpaces();
+            size_t start = this->pos;
+            if (this->pos < this->s.length() && this->IsIdentStart(this->s[this->pos])) {
+                while (this->pos < this->s.length() && this->IsIdentPart(this->s[this->pos]))
+                    this->pos++;
+            }
+            return this->s.substr(start, this->pos - start);
+        }
+
+        // AcceptKeyword accepts a keyword that is not the prefix of a longer identifier.
+        bool AcceptKeyword(string keyword) {
+            if (!this->Peek(keyword))
+                return false;
+            size_t end = this->pos + keyword.length();
+            if (end < this->s.length() && this->IsIdentPart(this->s[end]))
+                return false;
+            this->pos = end;
+            return true;
+        }
+
+        shared_ptr<MatcherNode> Fail() {
+            this->ok = false;
+            return NULL;
+        }
+
+        shared_ptr<MatcherNode> Binary(MatcherNode :: Kind kind, shared_ptr<MatcherNode> left, shared_ptr<MatcherNode> right) {
+            if (left == NULL || right == NULL)
+                return this->Fail();
+            shared_ptr<MatcherNode> node(new MatcherNode(kind));
+            node->children.push_back(left);
+            node->children.push_back(right);
+            return node;
+        }
+
+        shared_ptr<MatcherNode> ParseOr() {
+            shared_ptr<MatcherNode> left = this->ParseAnd();
+            while (this->ok && this->Accept("||"))
+                left = this->Binary(MatcherNode :: Kind :: Or, left, this->ParseAnd());
+            return left;
+        }
+
+        shared_ptr<MatcherNode> ParseAnd() {
+            shared_ptr<MatcherNode> left = this->ParseEquality();
+            while (this->ok && this->Accept("&&"))
+                left = this->Binary(MatcherNode :: Kind :: And, left, this->ParseEquality());
+            return left;
+        }
+
+        shared_ptr<MatcherNode> ParseEquality() {
+            shared_ptr<MatcherNode> left = this->ParseRelational();
+            while (this->ok) {
+                // Strict equality is left to the JavaScript engine.
+                if (this->Peek("===") || this->Peek("!=="))
+                    return this->Fail();
+                if (this->Accept("=="))
+                    left = this->Binary(MatcherNode :: Kind :: Equal, left, this->ParseRelational());
+                else if (this->Accept("!="))
+                    left = this->Binary(MatcherNode :: Kind :: NotEqual, left, this->ParseRelational());
+                else
+                    break;
+            }
+            return left;
+        }
+
+        shared_ptr<MatcherNode> ParseRelational() {
+            shared_ptr<MatcherNode> left = this->ParseUnary();
+            while (this->ok && this->AcceptKeyword("in")) {
+                if (!this->Accept("("))
+                    return this->Fail();
+                shared_ptr<MatcherNode> tuple(new MatcherNode(MatcherNode :: Kind :: Tuple));
+                if (!this->Accept(")")) {
+                    do {
+                        shared_ptr<MatcherNode> item = this->ParseOr();
+                        if (item == NULL)
+                            return this->Fail();
+                        tuple->children.push_back(item);
+                    } while (this->Accept(","));
+                    if (!this->Accept(")"))
+                        return this->Fail();
+                }
+                left = this->Binary(MatcherNode :: Kind :: In, left, tuple);
+            }
+            return left;
+        }
+
+        shared_ptr<MatcherNode> ParseUnary() {
+            if (this->Peek("!") && !this->Peek("!=")) {
+                this->Accept("!");
+                shared_ptr<MatcherNode> operand = this->ParseUnary();
+                if (operand == NULL)
+                    return this->Fail();
+                shared_ptr<MatcherNode> node(new MatcherNode(MatcherNode :: Kind :: Not));
+                node->children.push_back(operand);
+                return node;
+            }
+            return this->ParsePrimary();
+        }
+
+        shared_ptr<MatcherNode> ParsePrimary() {
+            this->SkipSpaces();
+            if (this->pos >= this->s.length())
+                return this->Fail();
+
+            char c = this->s[this->pos];
+            if (c == '(') {
+                this->pos++;
+                shared_ptr<MatcherNode> node = this->ParseOr();
+                if (node == NULL || !this->Accept(")"))
+                    return this->Fail();
+                return node;
+            }
+            if (c == '"' || c == '\'')
+                return this->ParseString(c);
+            if (isdigit((unsigned char)c))
+                return this->ParseNumber();
+            if (!this->IsIdentStart(c))
+                return this->Fail();
+
+            string name = this->Identifier();
+            if (name == "true" || name == "false") {
+                shared_ptr<MatcherNode> node(new MatcherNode(MatcherNode :: Kind :: Literal));
+                node->text = name;
+                node->value = MatcherValue :: FromBool(name == "true");
+                return node;
+            }
+
+            if (this->Accept("(")) {
+                shared_ptr<MatcherNode> node(new MatcherNode(MatcherNode :: Kind :: Call));
+                node->name = name;
+                if (!this->Accept(")")) {
+                    do {
+                        shared_ptr<MatcherNode> arg = this->ParseOr();
+                        if (arg == NULL)
+                            return this->Fail();
+                        node->children.push_back(arg);
+                    } while (this->Accept(","));
+                    if (!this->Accept(")"))
+                        return this->Fail();
+                }
+                return node;
+            }
+
+            // Only one level of r./p. accessors is supported natively, e.g. r.obj.Owner is not.
+            if ((name != "r" && name != "p") || !this->Accept("."))
+                return this->Fail();
+            string field = this->Identifier();
+            if (field == "" || this->Peek(".") || this->Peek("["))
+                return this->Fail();
+
+            shared_ptr<MatcherNode> node(new MatcherNode(name == "r" ? MatcherNode :: Kind :: RequestField : MatcherNode :: Kind :: PolicyField));
+            node->name = field;
+            return node;
+        }
+
+        // HexValue returns the value of a hexadecimal digit, or -1 if c is not one.
+        static int HexValue(char c) {
+            if (c >= '0' && c <= '9')
+                return c - '0';
+            if (c >= 'a' && c <= 'f')
+                return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F')
+                return c - 'A' + 10;
+            return -1;
+        }
+
+        // ParseHex reads exactly count hexadecimal digits, it returns -1 if there are not enough.
+        int ParseHex(int count) {
+            int value = 0;
+            for (int i = 0 ; i < count ; i++) {
+                int digit = this->pos < this->s.length() ? HexValue(this->s[this->pos]) : -1;
+                if (digit == -1)
+                    return -1;
+                value = value * 16 + digit;
+                this->pos++;
+            }
+            return value;
+        }
+
+        // AppendCodePoint appends a code point of the Basic Multilingual Plane as UTF-8. Surrogates are not accepted,
+        // the JavaScript engine keeps them as separate UTF-16 code units, which have no UTF-8 encoding.
+        static bool AppendCodePoint(string& text, int code_point) {
+            if (code_point < 0 || code_point > 0xFFFF || (code_point >= 0xD800 && code_point <= 0xDFFF))
+                return false;
+            if (code_point < 0x80)
+                text += char(code_point);
+            else if (code_point < 0x800) {
+                text += char(0xC0 | (code_point >> 6));
+                text += char(0x80 | (code_point & 0x3F));
+            } else {
+                text += char(0xE0 | (code_point >> 12));
+                text += char(0x80 | ((code_point >> 6) & 0x3F));
+                text += char(0x80 | (code_point & 0x3F));
+            }
+            return true;
+        }
+
+        // ParseEscape reads the escape sequence after a backslash the same way JavaScript does. Legacy octal escapes,
+        // line continuations and code points outside of the Basic Multilingual Plane are left to the JavaScript engine.
+        bool ParseEscape(string& text) {
+            if (this->pos >= this->s.length())
+                return false;
+
+            char c = this->s[this->pos++];
+            switch (c) {
+                case 'n': text += '\n'; return true;
+                case 't': text += '\t'; return true;
+                case 'r': text += '\r'; return true;
+                case 'b': text += '\b'; return true;
+                case 'f': text += '\f'; return true;
+                case 'v': text += '\v'; return true;
+                case '0':
+                    if (this->pos < this->s.length() && isdigit((unsigned char)this->s[this->pos]))
+                        return false;
+                    text += '\0';
+                    return true;
+                case 'x':
+                    return AppendCodePoint(text, this->ParseHex(2));
+                case 'u': {
+                    if (this->pos < this->s.length() && this->s[this->pos] == '{') {
+                        this->pos++;
+                        int code_point = 0;
+                        int digits = 0;
+                        for ( ; this->pos < this->s.length() && HexValue(this->s[this->pos]) != -1 && digits < 6 ; this->pos++, digits++)
+                            code_point = code_point * 16 + HexValue(this->s[this->pos]);
+                        if (digits == 0 || this->pos >= this->s.length() || this->s[this->pos] != '}')
+                            return false;
+                        this->pos++;
+                        return AppendCodePoint(text, code_point);
+                    }
+                    return AppendCodePoint(text, this->ParseHex(4));
+                }
+                case '\r':
+                case '\n':
+                    return false;
+                default:
+                    if (isdigit((unsigned char)c))
+                        return false;
+                    // Any other character stands for itself, e.g. \' or \a.
+                    text += c;
+                    return true;
+            }
+        }
+
+        shared_ptr<MatcherNode> ParseString(char quote) {
+            string text;
+            this->pos++;
+            while (this->pos < this->s.length() && this->s[this->pos] != quote) {
+                char c = this->s[this->pos++];
+                if (c == '\r' || c == '\n')
+                    return this->Fail();
+                if (c != '\\')
+                    text += c;
+                else if (!this->ParseEscape(text))
+                    return this->Fail();
+            }
+            if (this->pos >= this->s.length())
+                return this->Fail();
+            this->pos++;
+
+            shared_ptr<MatcherNode> node(new MatcherNode(MatcherNode :: Kind :: Literal));
+            node->text = text;
+            node->value = MatcherValue :: FromString(&node->text);
+            return node;
+        }
+
+        // ParseNumber reads a decimal literal: an integer without leading zeros, an optional fraction and an optional exponent.
+        // Hexadecimal, octal and binary literals are left to the JavaScript engine.
+        shared_ptr<MatcherNode> ParseNumber() {
+            size_t start = this->pos;
+            if (this->s[this->pos] == '0' && this->pos + 1 < this->s.length() && (isdigit((unsigned char)this->s[this->pos + 1]) || this->IsIdentPart(this->s[this->pos + 1])))
+                return this->Fail();
+            while (this->pos < this->s.length() && isdigit((unsigned char)this->s[this->pos]))
+                this->pos++;
+            if (this->pos < this->s.length() && this->s[this->pos] == '.') {
+                this->pos++;
+                while (this->pos < this->s.length() && isdigit((unsigned char)this->s[this->pos]))
+                    this->pos++;
+            }
+            if (this->pos < this->s.length() && (this->s[this->pos] == 'e' || this->s[this->pos] == 'E')) {
+                this->pos++;
+                if (this->pos < this->s.length() && (this->s[this->pos] == '+' || this->s[this->pos] == '-'))
+                    this->pos++;
+                if (this->pos >= this->s.length() || !isdigit((unsigned char)this->s[this->pos]))
+                    return this->Fail();
+                while (this->pos < this->s.length() && isdigit((unsigned char)this->s[this->pos]))
+                    this->pos++;
+            }
+            // A literal must not be followed by an identifier, a digit or another dot, e.g. 1.2.3 is a syntax error.
+            if (this->pos < this->s.length() && (this->IsIdentPart(this->s[this->pos]) || this->s[this->pos] == '.'))
+                return this->Fail();
+
+            shared_ptr<MatcherNode> node(new MatcherNode(MatcherNode :: Kind :: Literal));
+            node->text = this->s.substr(start, this->pos - start);
+            // The literal is read in the classic locale, the decimal point of the process locale may be different.
+            istringstream in(node->text);
+            in.imbue(locale :: classic());
+            double number;
+            in >> number;
+            node->value = MatcherValue :: FromNumber(number);
+            return node;
+        }
+
+    public:
+
+        MatcherParser(string s) {
+            this->s = s;
+            this->pos = 0;
+            this->ok = true;
+        }
+
+        shared_ptr<MatcherNode> Parse() {
+            shared_ptr<MatcherNode> root = this->ParseOr();
+            this->SkipSpaces();
+            if (!this->ok || this->pos != this->s.length())
+                return NULL;
+            return root;
+        }
+};
+
+// HasStringValue returns true if the node always evaluates to a string without failing.
+static bool HasStringValue(MatcherNode* node) {
+    switch(node->kind) {
+        case MatcherNode :: Kind :: Literal:
+            return node->value.kind == MatcherValue :: Kind :: String;
+        case MatcherNode :: Kind :: RequestField:
+        case MatcherNode :: Kind :: PolicyField:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// CannotFail returns true if the evaluation of the node against a policy rule never fails or throws,
+// so that whether it is evaluated or not does not change the result.
+static bool CannotFail(MatcherNode* node) {
+    switch(node->kind) {
+        case MatcherNode :: Kind :: Literal:
+        case MatcherNode :: Kind :: RequestField:
+        case MatcherNode :: Kind :: PolicyField:
+            return true;
+        case MatcherNode :: Kind :: Call:
+        case MatcherNode :: Kind :: GCall:
+            // regexMatch and ipMatch throw on a malformed pattern or address.
+            if (node->kind == MatcherNode :: Kind :: Call && (node->name == "regexMatch" || node->name == "ipMatch"))
+                return false;
+            // Only string arguments are accepted, any other value makes the call fail.
+            for (int i = 0 ; i < node->children.size() ; i++) {
+                if (!HasStringValue(node->children[i].get()))
+                    return false;
+            }
+            return true;
+        default:
+            for (int i = 0 ; i < node->children.size() ; i++) {
+                if (!CannotFail(node->children[i].get()))
+                    return false;
+            }
+            return true;
+    }
+}
+
+// HasBooleanValue returns true if the node always evaluates to a boolean without failing,
+// so that it can be moved around && and || without changing the result.
+static bool HasBooleanValue(MatcherNode* node) {
+    if (!CannotFail(node))
+        return false;
+
+    switch(node->kind) {
+        case MatcherNode :: Kind :: Literal:
+            return node->value.kind == MatcherValue :: Kind :: Bool;
+        case MatcherNode :: Kind :: Equal:
+        case MatcherNode :: Kind :: NotEqual:
+        case MatcherNode :: Kind :: In:
+        case MatcherNode :: Kind :: Not:
+        case MatcherNode :: Kind :: Call:
+        case MatcherNode :: Kind :: GCall:
+            return true;
+        case MatcherNode :: Kind :: And:
+        case MatcherNode :: Kind :: Or:
+            return HasBooleanValue(node->children[0].get()) && HasBooleanValue(node->children[1].get());
+        default:
+            return false;
+    }
+}
+
+// CopyNode copies a node without its children, the copy starts without short circuits.
+static shared_ptr<MatcherNode> CopyNode(MatcherNode* node) {
+    shared_ptr<MatcherNode> copy(new MatcherNode(node->kind));
+    copy->value = node->value;
+    copy->text = node->text;
+    if (node->value.str == &node->text)
+        copy->value.str = &copy->text;
+    copy->name = node->name;
+    copy->index = node->index;
+    copy->func = node->func;
+    copy->g = node->g;
+    copy->invariant = node->invariant;
+    return copy;
+}
+
+// Cost estimates the cost of evaluating the node for a policy rule: literal compare < field compare < keyMatch < g() < regexMatch/ipMatch.
+// Request-invariant sub-expressions are evaluated once per request and cost nothing per rule.
+static double Cost(MatcherNode* node) {
+    if (node->invariant)
+        return 0;
+
+    double cost = 0;
+    for (int i = 0 ; i < node->children.size() ; i++)
+        cost += Cost(node->children[i].get());
+
+    switch(node->kind) {
+        case MatcherNode :: Kind :: Equal:
+        case MatcherNode :: Kind :: NotEqual:
+            if (node->children[0]->kind == MatcherNode :: Kind :: Literal || node->children[1]->kind == MatcherNode :: Kind :: Literal)
+                return cost + 1;
+            return cost + 2;
+        case MatcherNode :: Kind :: In:
+            return cost + 1 + double(node->children[1]->children.size());
+        case MatcherNode :: Kind :: Call:
+            if (node->name == "regexMatch" || node->name == "ipMatch")
+                return cost + 40;
+            return cost + 10;
+        case MatcherNode :: Kind :: GCall:
+            return cost + 20;
+        default:
+            return cost;
+    }
+}
+
+// FalseChance estimates how likely the node is to be falsy for a policy rule, equality with a policy field is the most selective.
+static double FalseChance(MatcherNode* node) {
+    switch(node->kind) {
+        case MatcherNode :: Kind :: Literal:
+            return node->value.Truthy() ? 0 : 1;
+        case MatcherNode :: Kind :: Equal:
+            return 0.9;
+        case MatcherNode :: Kind :: NotEqual:
+            return 0.1;
+        case MatcherNode :: Kind :: In:
+            return 0.8;
+        case MatcherNode :: Kind :: Not:
+            return 1 - FalseChance(node->children[0].get());
+        case MatcherNode :: Kind :: Call:
+            if (node->name == "regexMatch" || node->name == "ipMatch")
+                return 0.5;
+            return 0.7;
+        case MatcherNode :: Kind :: And:
+            return 1 - (1 - FalseChance(node->children[0].get())) * (1 - FalseChance(node->children[1].get()));
+        case MatcherNode :: Kind :: Or:
+            return FalseChance(node->children[0].get()) * FalseChance(node->children[1].get());
+        default:
+            return 0.5;
+    }
+}
+
+// NodeToString prints a node back as a matcher expression.
+static string NodeToString(MatcherNode* node) {
+    switch(node->kind) {
+        case MatcherNode :: Kind :: Literal:
+            if (node->value.kind == MatcherValue :: Kind :: String)
+                return "\"" + node->text + "\"";
+            return node->text;
+        case MatcherNode :: Kind :: RequestField:
+            return "r." + node->name;
+        case MatcherNode :: Kind :: PolicyField:
+            return "p." + node->name;
+        case MatcherNode :: Kind :: Not:
+            return "!" + NodeToString(node->children[0].get());
+        case MatcherNode :: Kind :: And:
+            return "(" + NodeToString(node->children[0].get()) + " && " + NodeToString(node->children[1].get()) + ")";
+        case MatcherNode :: Kind :: Or:
+            return "(" + NodeToString(node->children[0].get()) + " || " + NodeToString(node->children[1].get()) + ")";
+        case MatcherNode :: Kind :: Equal:
+            return NodeToString(node->children[0].get()) + " == " + NodeToString(node->children[1].get());
+        case MatcherNode :: Kind :: NotEqual:
+            return NodeToString(node->children[0].get()) + " != " + NodeToString(node->children[1].get());
+        case MatcherNode :: Kind :: In:
+            return NodeToString(node->children[0].get()) + " in " + NodeToString(node->children[1].get());
+        default: {
+            string args;
+            for (int i = 0 ; i < node->children.size() ; i++)
+                args += (i == 0 ? "" : ", ") + NodeToString(node->children[i].get());
+            if (node->kind == MatcherNode :: Kind :: Tuple)
+                return "(" + args + ")";
+            return node->name + "(" + args + ")";
+        }
+    }
+}
+
+// The built-in functions that have a native implementation, keyed by the name they are registered with.
+unordered_map<string, pair<Function, NativeFunction>> Matcher :: native_functions = {
+    {"keyMatch", {(Function)KeyMatch, (NativeFunction)KeyMatch}},
+    {"keyMatch2", {(Function)KeyMatch2, (NativeFunction)KeyMatch2}},
+    {"keyMatch3", {(Function)KeyMatch3, (NativeFunction)KeyMatch3}},
+    {"regexMatch", {(Function)RegexMatch, (NativeFunction)RegexMatch}},
+    {"ipMatch", {(Function)IPMatch, (NativeFunction)IPMatch}}
+};
+
+Matcher :: Matcher() {
+    this->bound = false;
+    this->uses_policy = false;
+    this->reordering = true;
+}
+
+// NewMatcher parses a matcher expression, the matcher is not native if the expression uses unsupported syntax.
+shared_ptr<Matcher> Matcher :: NewMatcher(string expression) {
+    shared_ptr<Matcher> matcher(new Matcher());
+    matcher->expression = expression;
+    matcher->written_root = MatcherParser(expression).Parse();
+    matcher->root = matcher->written_root;
+    return matcher;
+}
+
+bool Matcher :: BindNode(shared_ptr<MatcherNode> node, vector<string>& r_tokens, vector<string>& p_tokens, unordered_map<string, Function>& functions, unordered_map<string, shared_ptr<Assertion>>* g_assertions) {
+    switch(node->kind) {
+        case MatcherNode :: Kind :: RequestField:
+        case MatcherNode :: Kind :: PolicyField: {
+            vector<string>& tokens = node->kind == MatcherNode :: Kind :: RequestField ? r_tokens : p_tokens;
+            string token = (node->kind == MatcherNode :: Kind :: RequestField ? "r_" : "p_") + node->name;
+            node->index = -1;
+            for (int i = 0 ; i < tokens.size() ; i++) {
+                if (tokens[i] == token) {
+                    node->index = i;
+                    break;
+                }
+            }
+            if (node->index == -1)
+                return false;
+            if (node->kind == MatcherNode :: Kind :: PolicyField)
+                this->uses_policy = true;
+            break;
+        }
+        case MatcherNode :: Kind :: Call:
+        case MatcherNode :: Kind :: GCall: {
+            node->kind = MatcherNode :: Kind :: Call;
+            node->func = NULL;
+            node->g = NULL;
+            if (g_assertions != NULL && g_assertions->find(node->name) != g_assertions->end()) {
+                if (node->children.size() < 2 || node->children.size() > 3)
+                    return false;
+                node->kind = MatcherNode :: Kind :: GCall;
+                node->g = (*g_assertions)[node->name];
+                break;
+            }
+
+            // A function is native only if the registered function is still the built-in one.
+            unordered_map<string, pair<Function, NativeFunction>> :: iterator it = native_functions.find(node->name);
+            if (it == native_functions.end() || node->children.size() != 2)
+                return false;
+            unordered_map<string, Function> :: iterator registered = functions.find(node->name);
+            if (registered != functions.end() && registered->second != it->second.first)
+                return false;
+            node->func = it->second.second;
+            break;
+        }
+        default:
+            break;
+    }
+
+    for (int i = 0 ; i < node->children.size() ; i++) {
+        if (!this->BindNode(node->children[i], r_tokens, p_tokens, functions, g_assertions))
+            return false;
+    }
+
+    return true;
+}
+
+void Matcher :: CollectEqualityConjuncts(MatcherNode* node, vector<string>& r_tokens, vector<string>& p_tokens) {
+    if (node->kind == MatcherNode :: Kind :: And) {
+        this->CollectEqualityConjuncts(node->children[0].get(), r_tokens, p_tokens);
+        this->CollectEqualityConjuncts(node->children[1].get(), r_tokens, p_tokens);
+        return;
+    }
+    if (node->kind != MatcherNode :: Kind :: Equal)
+        return;
+
+    MatcherNode* r_field = node->children[0].get();
+    MatcherNode* p_field = node->children[1].get();
+    if (r_field->kind == MatcherNode :: Kind :: PolicyField)
+        swap(r_field, p_field);
+    if (r_field->kind != MatcherNode :: Kind :: RequestField || p_field->kind != MatcherNode :: Kind :: PolicyField)
+        return;
+
+    vector<string> :: iterator r_token = find(r_tokens.begin(), r_tokens.end(), "r_" + r_field->name);
+    vector<string> :: iterator p_token = find(p_tokens.begin(), p_tokens.end(), "p_" + p_field->name);
+    if (r_token != r_tokens.end() && p_token != p_tokens.end())
+        this->equality_conjuncts.push_back(make_pair(int(r_token - r_tokens.begin()), int(p_token - p_tokens.begin())));
+}
+
+// Bind resolves the r./p. accessors to token indices and the function calls to native implementations.
+// It returns false when the matcher must be evaluated by the JavaScript engine instead.
+bool Matcher :: Bind(vector<string> r_tokens, vector<string> p_tokens, unordered_map<string, Function>& functions, unordered_map<string, shared_ptr<Assertion>>* g_assertions) {
+    this->root = this->written_root;
+    this->uses_policy = false;
+    this->equality_conjuncts.clear();
+    this->invariant_nodes.clear();
+    if (this->root != NULL)
+        this->CollectEqualityConjuncts(this->root.get(), r_tokens, p_tokens);
+    this->bound = this->root != NULL && this->BindNode(this->root, r_tokens, p_tokens, functions, g_assertions);
+    if (this->bound) {
+        this->MarkInvariants(this->root.get());
+        if (this->reordering)
+            this->root = this->Reorder(this->root);
+        this->CollectInvariants(this->root.get());
+    }
+    return this->bound;
+}
+
+// Reorder sorts the operands of each chain of && or || so that cheap operands which are likely to decide the result come first,
+// i.e. by cost divided by the chance to short-circuit. Only chains of boolean operands that cannot fail are reordered, so the result
+// does not change. The nodes of the tree as written are not changed, a node is copied when its operands are reordered.
+shared_ptr<MatcherNode> Matcher :: Reorder(shared_ptr<MatcherNode> node) {
+    vector<shared_ptr<MatcherNode>> children(node->children.size());
+    bool changed = false;
+    for (int i = 0 ; i < node->children.size() ; i++) {
+        children[i] = this->Reorder(node->children[i]);
+        changed = changed || children[i] != node->children[i];
+    }
+    if (changed) {
+        node = CopyNode(node.get());
+        node->children = children;
+    }
+
+    if ((node->kind != MatcherNode :: Kind :: And && node->kind != MatcherNode :: Kind :: Or) || !HasBooleanValue(node.get()))
+        return node;
+
+    vector<shared_ptr<MatcherNode>> operands;
+    this->CollectOperands(node, node->kind, operands);
+
+    vector<pair<double, shared_ptr<MatcherNode>>> ranked;
+    for (int i = 0 ; i < operands.size() ; i++) {
+        double chance = FalseChance(operands[i].get());
+        if (node->kind == MatcherNode :: Kind :: Or)
+            chance = 1 - chance;
+        ranked.push_back(make_pair(Cost(operands[i].get()) / max(chance, 0.01), operands[i]));
+    }
+    stable_sort(ranked.begin(), ranked.end(), [](const pair<double, shared_ptr<MatcherNode>>& a, const pair<double, shared_ptr<MatcherNode>>& b) {
+        return a.first < b.first;
+    });
+
+    shared_ptr<MatcherNode> chain = ranked[0].second;
+    for (int i = 1 ; i < ranked.size() ; i++) {
+        shared_ptr<MatcherNode> parent(new MatcherNode(node->kind));
+        parent->children.push_back(chain);
+        parent->children.push_back(ranked[i].second);
+        parent->invariant = chain->invariant && ranked[i].second->invariant;
+        chain = parent;
+    }
+    return chain;
+}
+
+void Matcher :: CollectOperands(shared_ptr<MatcherNode> node, MatcherNode :: Kind kind, vector<shared_ptr<MatcherNode>>& operands) {
+    if (node->kind != kind) {
+        operands.push_back(node);
+        return;
+    }
+    this->CollectOperands(node->children[0], kind, operands);
+    this->CollectOperands(node->children[1], kind, operands);
+}
+
+// EnableReordering controls whether Bind reorders the operands of && and || by estimated cost and selectivity, it is enabled by default.
+void Matcher :: EnableReordering(bool reordering) {
+    this->reordering = reordering;
+}
+
+// ShortCircuitCounts returns, for every operand of && and ||, how often it decided the result on its own.
+vector<pair<string, unsigned long long>> Matcher :: ShortCircuitCounts() {
+    vector<pair<string, unsigned long long>> counts;
+    if (this->bound)
+        this->CollectShortCircuits(this->root.get(), counts);
+    return counts;
+}
+
+void Matcher :: CollectShortCircuits(MatcherNode* node, vector<pair<string, unsigned long long>>& counts) {
+    for (int i = 0 ; i < node->children.size() ; i++) {
+        MatcherNode* child = node->children[i].get();
+        if ((node->kind == MatcherNode :: Kind :: And || node->kind == MatcherNode :: Kind :: Or) && child->kind != node->kind)
+            counts.push_back(make_pair(NodeToString(child), child->short_circuits.load()));
+        this->CollectShortCircuits(child, counts);
+    }
+}
+
+// MarkInvariants marks the nodes that do not reference any p. field, so their value is the same for every policy rule.
+bool Matcher :: MarkInvariants(MatcherNode* node) {
+    node->invariant = node->kind != MatcherNode :: Kind :: PolicyField;
+    for (int i = 0 ; i < node->children.size() ; i++) {
+        if (!this->MarkInvariants(node->children[i].get()))
+            node->invariant = false;
+    }
+    return node->invariant;
+}
+
+// CollectInvariants gives a slot to the largest invariant sub-expressions that are worth evaluating once per request,
+// literals and request fields are already cheap to read.
+void Matcher :: CollectInvariants(MatcherNode* node) {
+    node->slot = -1;
+    if (node->invariant && node->kind != MatcherNode :: Kind :: Literal && node->kind != MatcherNode :: Kind :: RequestField && node->kind != MatcherNode :: Kind :: Tuple) {
+        node->slot = int(this->invariant_nodes.size());
+        this->invariant_nodes.push_back(node);
+        return;
+    }
+    for (int i = 0 ; i < node->children.size() ; i++)
+        this->CollectInvariants(node->children[i].get());
+}
+
+// IsNative returns true if the matcher has been parsed and bound successfully.
+bool Matcher :: IsNative() {
+    return this->bound;
+}
+
+// UsesPolicy returns true if the matcher references any p. field.
+bool Matcher :: UsesPolicy() {
+    return this->uses_policy;
+}
+
+// EqualityConjuncts returns the (r token, p token) index pairs of the top-level conjuncts like r.sub == p.sub,
+// a rule can only match if each of these policy columns equals the request value. It is filled by Bind, even when the matcher is not native.
+const vector<pair<int, int>>& Matcher :: EqualityConjuncts() {
+    return this->equality_conjuncts;
+}
+
+MatcherValue Matcher :: EvaluateNode(MatcherNode* node, const vector<string>& r_vals, const vector<int>* r_symbols, const PolicyView :: Rule* p_rule, const vector<MatcherValue>* invariants, bool& failed) {
+    if (invariants != NULL && node->slot != -1)
+        return (*invariants)[node->slot];
+
+    switch(node->kind) {
+        case MatcherNode :: Kind :: Literal:
+            return node->value;
+        case MatcherNode :: Kind :: RequestField:
+            if (r_symbols != NULL)
+                return MatcherValue :: FromSymbol(&r_vals[node->index], (*r_symbols)[node->index]);
+            return MatcherValue :: FromString(&r_vals[node->index]);
+        case MatcherNode :: Kind :: PolicyField:
+            if (p_rule == NULL) {
+                failed = true;
+                return MatcherValue :: FromBool(false);
+            }
+            return MatcherValue :: FromSymbol(&(*p_rule)[node->index], p_rule->Symbol(node->index));
+        case MatcherNode :: Kind :: Not:
+            return MatcherValue :: FromBool(!this->EvaluateNode(node->children[0].get(), r_vals, r_symbols, p_rule, invariants, failed).Truthy());
+        case MatcherNode :: Kind :: And: {
+            MatcherValue left = this->EvaluateNode(node->children[0].get(), r_vals, r_symbols, p_rule, invariants, failed);
+            if (!left.Truthy()) {
+                node->children[0]->short_circuits.fetch_add(1, memory_order_relaxed);
+                return left;
+            }
+            MatcherValue right = this->EvaluateNode(node->children[1].get(), r_vals, r_symbols, p_rule, invariants, failed);
+            if (!right.Truthy())
+                node->children[1]->short_circuits.fetch_add(1, memory_order_relaxed);
+            return right;
+        }
+        case MatcherNode :: Kind :: Or: {
+            MatcherValue left = this->EvaluateNode(node->children[0].get(), r_vals, r_symbols, p_rule, invariants, failed);
+            if (left.Truthy()) {
+                node->children[0]->short_circuits.fetch_add(1, memory_order_relaxed);
+                return left;
+            }
+            MatcherValue right = this->EvaluateNode(node->children[1].get(), r_vals, r_symbols, p_rule, invariants, failed);
+            if (right.Truthy())
+                node->children[1]->short_circuits.fetch_add(1, memory_order_relaxed);
+            return right;
+        }
+        case MatcherNode :: Kind :: Equal:
+        case MatcherNode :: Kind :: NotEqual: {
+            MatcherValue left = this->EvaluateNode(node->children[0].get(), r_vals, r_symbols, p_rule, invariants, failed);
+            MatcherValue right = this->EvaluateNode(node->children[1].get(), r_vals, r_symbols, p_rule, invariants, failed);
+            bool equal = left.Equals(right);
+            return MatcherValue :: FromBool(node->kind == MatcherNode :: Kind :: Equal ? equal : !equal);
+        }
+        case MatcherNode :: Kind :: In: {
+            MatcherValue left = this->EvaluateNode(node->children[0].get(), r_vals, r_symbols, p_rule, invariants, failed);
+            MatcherNode* tuple = node->children[1].get();
+            for (int i = 0 ; i < tuple->children.size() ; i++) {
+                if (left.Equals(this->EvaluateNode(tuple->children[i].get(), r_vals, r_symbols, p_rule, invariants, failed)))
+                    return MatcherValue :: FromBool(true);
+            }
+            return MatcherValue :: FromBool(false);
+        }
+        case MatcherNode :: Kind :: Call: {
+            MatcherValue arg1 = this->EvaluateNode(node->children[0].get(), r_vals, r_symbols, p_rule, invariants, failed);
+            MatcherValue arg2 = this->EvaluateNode(node->children[1].get(), r_vals, r_symbols, p_rule, invariants, failed);
+            if (failed || arg1.kind != MatcherValue :: Kind :: String || arg2.kind != MatcherValue :: Kind :: String) {
+                failed = true;
+                return MatcherValue :: FromBool(false);
+            }
+            return MatcherValue :: FromBool(node->func(*arg1.str, *arg2.str));
+        }
+        case MatcherNode :: Kind :: GCall: {
+            vector<MatcherValue> args;
+            for (int i = 0 ; i < node->children.size() ; i++) {
+                args.push_back(this->EvaluateNode(node->children[i].get(), r_vals, r_symbols, p_rule, invariants, failed));
+                if (failed || args[i].kind != MatcherValue :: Kind :: String) {
+                    failed = true;
+                    return MatcherValue :: FromBool(false);
+                }
+            }
+
+            // Same semantics as GFunctionWithRoleManager: without a role manager only identical names are linked.
+            RoleManager* rm = node->g->rm.get();
+            if (rm == NULL)
+                return MatcherValue :: FromBool(*args[0].str == *args[1].str);
+
+            vector<string> domain;
+            if (args.size() == 3)
+                domain.push_back(*args[2].str);
+            return MatcherValue :: FromBool(rm->HasLink(*args[0].str, *args[1].str, domain));
+        }
+        default:
+            failed = true;
+            return MatcherValue :: FromBool(false);
+    }
+}
+
+// LookupRequest looks the request values up in the symbol table of the policy view the rules are read from,
+// values that are not in it get the symbol -1.
+void Matcher :: LookupRequest(const PolicyView& policy, const vector<string>& r_vals, vector<int>& r_symbols) {
+    const SymbolTable& symbols = policy.Symbols();
+    r_symbols.resize(r_vals.size());
+    for (int i = 0 ; i < r_vals.size() ; i++)
+        r_symbols[i] = symbols.Find(r_vals[i]);
+}
+
+// Evaluate evaluates the matcher against a request and a policy rule, p_rule is NULL when there is no policy.
+// It returns false when the evaluation fails, e.g. a p. field is accessed without a policy rule.
+bool Matcher :: Evaluate(const vector<string>& r_vals, const vector<int>* r_symbols, const PolicyView :: Rule* p_rule, MatcherValue& result, const vector<MatcherValue>* invariants) {
+    bool failed = false;
+    // Without a policy rule a p. field fails, so the operands are evaluated in the order they are written.
+    MatcherNode* root = p_rule == NULL ? this->written_root.get() : this->root.get();
+    result = this->EvaluateNode(root, r_vals, r_symbols, p_rule, invariants, failed);
+    return !failed;
+}
+
+// EvaluateInvariants evaluates once for a request the sub-expressions that do not reference any p. field.
+// It returns false when they cannot be evaluated apart from the policy rules, then invariants must not be used.
+bool Matcher :: EvaluateInvariants(const vector<string>& r_vals, vector<MatcherValue>& invariants) {
+    invariants.resize(this->invariant_nodes.size());
+    bool failed = false;
+    // An invariant may not be reached by the evaluation of a rule, so one that throws is left to the evaluation of the rules.
+    try {
+        for (int i = 0 ; i < this->invariant_nodes.size() ; i++)
+            invariants[i] = this->EvaluateNode(this->invariant_nodes[i], r_vals, NULL, NULL, NULL, failed);
+    } catch (...) {
+        return false;
+    }
+    return !failed;
+}
+
+// Decide returns true if the request-invariant values decide the matcher for every policy rule, result is then its value.
+bool Matcher :: Decide(const vector<MatcherValue>& invariants, MatcherValue& result) {
+    return this->bound && this->DecideNode(this->root.get(), invariants, result);
+}
+
+bool Matcher :: DecideNode(MatcherNode* node, const vector<MatcherValue>& invariants, MatcherValue& result) {
+    if (node->slot != -1) {
+        result = invariants[node->slot];
+        return true;
+    }
+
+    switch(node->kind) {
+        case MatcherNode :: Kind :: Literal:
+            result = node->value;
+            return true;
+        case MatcherNode :: Kind :: Not:
+            if (!this->DecideNode(node->children[0].get(), invariants, result))
+                return false;
+            result = MatcherValue :: FromBool(!result.Truthy());
+            return true;
+        case MatcherNode :: Kind :: And:
+            // a && b is falsy for every rule if a is, or if b is and a cannot fail, and is b if a is always truthy.
+            if (this->DecideNode(node->children[0].get(), invariants, result))
+                return result.Truthy() ? this->DecideNode(node->children[1].get(), invariants, result) : true;
+            return CannotFail(node->children[0].get()) && this->DecideNode(node->children[1].get(), invariants, result) && !result.Truthy();
+        case MatcherNode :: Kind :: Or:
+            // a || b is a if a is always truthy, and is b if a is always falsy.
+            if (!this->DecideNode(node->children[0].get(), invariants, result))
+                return false;
+            return result.Truthy() ? true : this->DecideNode(node->children[1].get(), invariants, result);
+        default:
+            return false;
+    }
+}
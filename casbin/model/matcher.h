@@ -0,0 +1,175 @@
+/*
+* Copyright 2020 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef CASBIN_CPP_MODEL_MATCHER
+#define CASBIN_CPP_MODEL_MATCHER
+
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+
+#include "./assertion.h"
+#include "./scope_config.h"
+
+using namespace std;
+
+typedef bool (*NativeFunction)(string, string);
+
+// MatcherValue is the value of a natively evaluated matcher sub-expression.
+// String values point into the request, the policy rule or the expression tree, so no copies are made.
+class MatcherValue {
+    public:
+        enum Kind {
+            Bool, Number, String
+        };
+
+        Kind kind;
+        bool boolean;
+        double number;
+        const string* str;
+        // symbol is the symbol of a string value in the symbol table of the policy, -1 if it is not known.
+        // Two strings with a symbol are equal if their symbols are.
+        int symbol;
+
+        MatcherValue();
+
+        static MatcherValue FromBool(bool b);
+
+        static MatcherValue FromNumber(double n);
+
+        static MatcherValue FromString(const string* s);
+
+        static MatcherValue FromSymbol(const string* s, int symbol);
+
+        // Truthy converts the value to a boolean the same way JavaScript does.
+        bool Truthy() const;
+
+        // ToNumber converts the value to a number the same way JavaScript does.
+        double ToNumber() const;
+
+        // Equals compares two values with the loose equality (==) of JavaScript.
+        bool Equals(const MatcherValue& other) const;
+};
+
+// MatcherNode is a node of the parsed matcher expression tree.
+class MatcherNode {
+    public:
+        enum Kind {
+            Literal, RequestField, PolicyField, Not, And, Or, Equal, NotEqual, In, Tuple, Call, GCall
+        };
+
+        Kind kind;
+        MatcherValue value;
+        string text;
+        string name;
+        int index;
+        NativeFunction func;
+        shared_ptr<Assertion> g;
+        vector<shared_ptr<MatcherNode>> children;
+        // invariant is true if the node does not reference any p. field, slot is the index of its value
+        // in the request-invariant values when it is evaluated once per request, -1 otherwise.
+        bool invariant;
+        int slot;
+        // short_circuits counts how often the node, as an operand of && or ||, decided the result on its own.
+        // It is updated by concurrent evaluations, so it is atomic.
+        atomic<unsigned long long> short_circuits;
+
+        MatcherNode(Kind kind);
+};
+
+// Matcher is the [matchers] expression parsed once into a native expression tree,
+// so it can be evaluated against a request and a policy rule without the JavaScript engine.
+class Matcher {
+    private:
+
+        static unordered_map<string, pair<Function, NativeFunction>> native_functions;
+
+        // root is the expression tree that is evaluated against the policy rules, with the operands of && and || reordered,
+        // written_root is the tree as written, it is evaluated without a policy rule, where a p. field fails.
+        shared_ptr<MatcherNode> root;
+        shared_ptr<MatcherNode> written_root;
+        bool bound;
+        bool uses_policy;
+        vector<pair<int, int>> equality_conjuncts;
+        vector<MatcherNode*> invariant_nodes;
+        bool reordering;
+
+        void CollectEqualityConjuncts(MatcherNode* node, vector<string>& r_tokens, vector<string>& p_tokens);
+
+        bool MarkInvariants(MatcherNode* node);
+
+        void CollectInvariants(MatcherNode* node);
+
+        bool DecideNode(MatcherNode* node, const vector<MatcherValue>& invariants, MatcherValue& result);
+
+        shared_ptr<MatcherNode> Reorder(shared_ptr<MatcherNode> node);
+
+        void CollectOperands(shared_ptr<MatcherNode> node, MatcherNode :: Kind kind, vector<shared_ptr<MatcherNode>>& operands);
+
+        void CollectShortCircuits(MatcherNode* node, vector<pair<string, unsigned long long>>& counts);
+
+        bool BindNode(shared_ptr<MatcherNode> node, vector<string>& r_tokens, vector<string>& p_tokens, unordered_map<string, Function>& functions, unordered_map<string, shared_ptr<Assertion>>* g_assertions);
+
+        MatcherValue EvaluateNode(MatcherNode* node, const vector<string>& r_vals, const vector<int>* r_symbols, const PolicyView :: Rule* p_rule, const vector<MatcherValue>* invariants, bool& failed);
+
+    public:
+
+        string expression;
+
+        Matcher();
+
+        // NewMatcher parses a matcher expression, the matcher is not native if the expression uses unsupported syntax.
+        static shared_ptr<Matcher> NewMatcher(string expression);
+
+        // Bind resolves the r./p. accessors to token indices and the function calls to native implementations.
+        // It returns false when the matcher must be evaluated by the JavaScript engine instead.
+        bool Bind(vector<string> r_tokens, vector<string> p_tokens, unordered_map<string, Function>& functions, unordered_map<string, shared_ptr<Assertion>>* g_assertions);
+
+        // EnableReordering controls whether Bind reorders the operands of && and || by estimated cost and selectivity, it is enabled by default.
+        void EnableReordering(bool reordering);
+
+        // ShortCircuitCounts returns, for every operand of && and ||, how often it decided the result on its own.
+        vector<pair<string, unsigned long long>> ShortCircuitCounts();
+
+        // IsNative returns true if the matcher has been parsed and bound successfully.
+        bool IsNative();
+
+        // UsesPolicy returns true if the matcher references any p. field.
+        bool UsesPolicy();
+
+        // EqualityConjuncts returns the (r token, p token) index pairs of the top-level conjuncts like r.sub == p.sub,
+        // a rule can only match if each of these policy columns equals the request value. It is filled by Bind, even when the matcher is not native.
+        const vector<pair<int, int>>& EqualityConjuncts();
+
+        // EvaluateInvariants evaluates once for a request the sub-expressions that do not reference any p. field.
+        // It returns false when they cannot be evaluated apart from the policy rules, then invariants must not be used.
+        bool EvaluateInvariants(const vector<string>& r_vals, vector<MatcherValue>& invariants);
+
+        // Decide returns true if the request-invariant values decide the matcher for every policy rule, result is then its value.
+        bool Decide(const vector<MatcherValue>& invariants, MatcherValue& result);
+
+        // LookupRequest looks the request values up in the symbol table of the policy view the rules are read from,
+        // values that are not in it get the symbol -1.
+        void LookupRequest(const PolicyView& policy, const vector<string>& r_vals, vector<int>& r_symbols);
+
+        // Evaluate evaluates the matcher against a request and a policy rule, p_rule is NULL when there is no policy.
+        // r_symbols are the symbols of the request values from LookupRequest, or NULL, and the policy rule is read as symbols.
+        // invariants are the values computed by EvaluateInvariants for the request, or NULL.
+        // It returns false when the evaluation fails, e.g. a p. field is accessed without a policy rule.
+        bool Evaluate(const vector<string>& r_vals, const vector<int>* r_symbols, const PolicyView :: Rule* p_rule, MatcherValue& result, const vector<MatcherValue>* invariants = NULL);
+};
+
+#endif
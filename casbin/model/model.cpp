@@ -98,7 +98,8 @@ bool Model :: AddDef(string sec, string key, string value) {
 
     if (m.find(sec) == m.end())
         m[sec] = AssertionMap();
-    ast->policy = vector<vector<string>>{};
+    ast->ClearRules();
+    ast->Publish();
 
     m[sec].assertion_map[key] = ast;
 
@@ -189,57 +190,65 @@ void Model :: PrintPolicy() {
     // }
 }
 
-// ClearPolicy clears all current policy.
+// ClearPolicy clears all current policy, the change is visible to the readers once it is published by PublishPolicy.
 void Model :: ClearPolicy() {
     for (unordered_map<string, shared_ptr<Assertion>> :: iterator it = this->m["p"].assertion_map.begin() ; it != this->m["p"].assertion_map.end() ; it++){
-        if((it->second)->policy.size() > 0)
-            (it->second)->policy.clear();
+        (it->second)->ClearRules();
     }
 
     for (unordered_map<string, shared_ptr<Assertion>> :: iterator it = this->m["g"].assertion_map.begin() ; it != this->m["g"].assertion_map.end() ; it++){
-        if((it->second)->policy.size() > 0)
-            (it->second)->policy.clear();
+        (it->second)->ClearRules();
     }
 }
 
+// DiscardPolicy drops the changes of all policies that have not been published, e.g. when an adapter fails to load the rules.
+void Model :: DiscardPolicy() {
+    for (unordered_map<string, shared_ptr<Assertion>> :: iterator it = this->m["p"].assertion_map.begin() ; it != this->m["p"].assertion_map.end() ; it++)
+        (it->second)->Discard();
+
+    for (unordered_map<string, shared_ptr<Assertion>> :: iterator it = this->m["g"].assertion_map.begin() ; it != this->m["g"].assertion_map.end() ; it++)
+        (it->second)->Discard();
+}
+
+// PublishPolicy makes the changes of all policies visible to the readers, e.g. after the rules have been loaded by an adapter.
+void Model :: PublishPolicy() {
+    for (unordered_map<string, shared_ptr<Assertion>> :: iterator it = this->m["p"].assertion_map.begin() ; it != this->m["p"].assertion_map.end() ; it++)
+        (it->second)->Publish();
+
+    for (unordered_map<string, shared_ptr<Assertion>> :: iterator it = this->m["g"].assertion_map.begin() ; it != this->m["g"].assertion_map.end() ; it++)
+        (it->second)->Publish();
+}
+
 // GetPolicy gets all rules in a policy.
 vector<vector<string>> Model :: GetPolicy(string sec, string p_type) {
-    return (this->m)[sec].assertion_map[p_type]->policy;
+    return this->GetPolicyView(sec, p_type).Values();
+}
+
+// GetPolicyView gets a read-only snapshot of the rules in a policy, the rules are not copied.
+PolicyView Model :: GetPolicyView(string sec, string p_type) {
+    return (this->m)[sec].assertion_map[p_type]->View();
 }
 
 // GetFilteredPolicy gets rules based on field filters from a policy.
 vector<vector<string>> Model :: GetFilteredPolicy(string sec, string p_type, int field_index, vector<string> field_values) {
-    vector<vector<string>> res;
-    vector<vector<string>> policy(m[sec].assertion_map[p_type]->policy);
-    for(int i = 0 ; i < policy.size() ; i++){
-        bool matched = true;
-        for(int j = 0 ; j < field_values.size() ; j++){
-            if(field_values[j] != "" && (policy[i])[field_index + j] != field_values[j] ){
-                matched = false;
-                break;
-            }
-        }
-        if(matched)
-            res.push_back(policy[i]);
-    }
+    return this->GetFilteredPolicyView(sec, p_type, field_index, field_values).Values();
+}
 
-    return res;
+// GetFilteredPolicyView gets a read-only snapshot of the rules based on field filters from a policy, the rules are not copied.
+PolicyView Model :: GetFilteredPolicyView(string sec, string p_type, int field_index, vector<string> field_values) {
+    return this->GetPolicyView(sec, p_type).Filter(field_index, field_values);
 }
 
 // HasPolicy determines whether a model has the specified policy rule.
 bool Model :: HasPolicy(string sec, string p_type, vector<string> rule) {
-    vector<vector<string>> policy = m[sec].assertion_map[p_type]->policy;
-    for(int i=0 ; i < policy.size() ; i++)
-        if (ArrayEquals(rule, policy[i]))
-            return true;
-
-    return false;
+    return m[sec].assertion_map[p_type]->HasRule(rule);
 }
 
 // AddPolicy adds a policy rule to the model.
 bool Model :: AddPolicy(string sec, string p_type, vector<string> rule) {
     if(!this->HasPolicy(sec, p_type, rule)) {
-        m[sec].assertion_map[p_type]->policy.push_back(rule);
+        m[sec].assertion_map[p_type]->AddRule(rule);
+        m[sec].assertion_map[p_type]->Publish();
         return true;
     }
 
@@ -253,84 +262,68 @@ bool Model :: AddPolicies(string sec, string p_type, vector<vector<string>> rule
             return false;
 
     for (int i = 0; i < rules.size(); i++)
-        this->m[sec].assertion_map[p_type]->policy.push_back(rules[i]);
+        this->m[sec].assertion_map[p_type]->AddRule(rules[i]);
+    this->m[sec].assertion_map[p_type]->Publish();
 
     return true;
 }
 
 // RemovePolicy removes a policy rule from the model.
 bool Model :: RemovePolicy(string sec, string p_type, vector<string> rule) {
-    for (int i = 0 ; i < m[sec].assertion_map[p_type]->policy.size() ; i++) {
-        if (ArrayEquals(rule, m[sec].assertion_map[p_type]->policy[i])) {
-            m[sec].assertion_map[p_type]->policy.erase(m[sec].assertion_map[p_type]->policy.begin() + i);
-            return true;
-        }
-    }
+    shared_ptr<Assertion> ast = m[sec].assertion_map[p_type];
+    int i = ast->FindRule(rule);
+    if (i == -1)
+        return false;
 
-    return false;
+    ast->RemoveRule(i);
+    ast->Publish();
+    return true;
 }
 
 // RemovePolicies removes policy rules from the model.
 bool Model :: RemovePolicies(string sec, string p_type, vector<vector<string>> rules) {
-    OUTER: for (int j = 0; j < rules.size(); j++) {
-        for (int i = 0; i < this->m[sec].assertion_map[p_type]->policy.size(); i++){
-            if (ArrayEquals(rules[j], this->m[sec].assertion_map[p_type]->policy[i]))
-                goto OUTER;
-        }
-        return false;
+    shared_ptr<Assertion> ast = this->m[sec].assertion_map[p_type];
+    for (int j = 0; j < rules.size(); j++) {
+        if (!ast->HasRule(rules[j]))
+            return false;
     }
 
-    for (int j = 0; j < rules.size(); j++){
-        for (int i = 0; i < this->m[sec].assertion_map[p_type]->policy.size(); i++){
-            if (ArrayEquals(rules[j], this->m[sec].assertion_map[p_type]->policy[i]))
-                this->m[sec].assertion_map[p_type]->policy.erase(this->m[sec].assertion_map[p_type]->policy.begin() + i);
-        }
+    for (int j = 0; j < rules.size(); j++) {
+        int i = ast->FindRule(rules[j]);
+        if (i != -1)
+            ast->RemoveRule(i);
     }
+    ast->Publish();
 
     return true;
 }
 
 // RemoveFilteredPolicy removes policy rules based on field filters from the model.
 pair<bool, vector<vector<string>>> Model :: RemoveFilteredPolicy(string sec, string p_type, int field_index, vector<string> field_values) {
-    vector<vector<string>> tmp;
-    vector<vector<string>> effects;
-    vector<vector<string>> policy(m[sec].assertion_map[p_type]->policy);
-    bool res = false;
-    for(int i = 0 ; i < policy.size() ; i++){
-        bool matched = true;
-        for (int j = 0 ; j < field_values.size() ; j++) {
-            if (field_values[j] != "" && (policy[i])[field_index+j] != field_values[j]) {
-                matched = false;
-                break;
-            }
-        }
-        if (matched){
-            effects.push_back(policy[i]);
-            res = true;
-        }
-        else
-            tmp.push_back(policy[i]);
-    }
+    shared_ptr<Assertion> ast = m[sec].assertion_map[p_type];
+    PolicyView removed = ast->View().Filter(field_index, field_values);
+
+    vector<int> indices(removed.Size());
+    for(int i = 0 ; i < removed.Size() ; i++)
+        indices[i] = removed.Index(i);
+    ast->RemoveRules(indices);
+    ast->Publish();
 
-    m[sec].assertion_map[p_type]->policy = tmp;
-    pair<bool, vector<vector<string>>> result(res, effects);
+    pair<bool, vector<vector<string>>> result(removed.Size() > 0, removed.Values());
     return result;
 }
 
 // GetValuesForFieldInPolicy gets all values for a field for all rules in a policy, duplicated values are removed.
 vector<string> Model :: GetValuesForFieldInPolicy(string sec, string p_type, int field_index) {
-    vector<string> values;
-    vector<vector<string>> policy(m[sec].assertion_map[p_type]->policy);
-    for(int i = 0 ; i < policy.size() ; i++)
-        values.push_back((policy[i])[field_index]);
-
-    ArrayRemoveDuplicates(values);
-
-    return values;
+    return m[sec].assertion_map[p_type]->DistinctValues(field_index);
 }
 
 // GetValuesForFieldInPolicyAllTypes gets all values for a field for all rules in a policy of all p_types, duplicated values are removed.
 vector<string> Model :: GetValuesForFieldInPolicyAllTypes(string sec, int field_index) {
+    // The values of a single policy type are distinct already.
+    if(m[sec].assertion_map.size() == 1)
+        return this->GetValuesForFieldInPolicy(sec, m[sec].assertion_map.begin()->first, field_index);
+
     vector<string> values;
 
     for (unordered_map<string, shared_ptr<Assertion>> :: iterator it = m[sec].assertion_map.begin() ; it != m[sec].assertion_map.end() ; it++) {
@@ -87,15 +87,27 @@ class Model{
         // PrintPolicy prints the policy to log.
         void PrintPolicy();
 
-        // ClearPolicy clears all current policy.
+        // ClearPolicy clears all current policy, the change is visible to the readers once it is published by PublishPolicy.
         void ClearPolicy();
 
+        // DiscardPolicy drops the changes of all policies that have not been published, e.g. when an adapter fails to load the rules.
+        void DiscardPolicy();
+
+        // PublishPolicy makes the changes of all policies visible to the readers, e.g. after the rules have been loaded by an adapter.
+        void PublishPolicy();
+
         // GetPolicy gets all rules in a policy.
         vector<vector<string>> GetPolicy(string sec, string p_type);
 
+        // GetPolicyView gets a read-only snapshot of the rules in a policy, the rules are not copied.
+        PolicyView GetPolicyView(string sec, string p_type);
+
         // GetFilteredPolicy gets rules based on field filters from a policy.
         vector<vector<string>> GetFilteredPolicy(string sec, string p_type, int field_index, vector<string> field_values);
 
+        // GetFilteredPolicyView gets a read-only snapshot of the rules based on field filters from a policy, the rules are not copied.
+        PolicyView GetFilteredPolicyView(string sec, string p_type, int field_index, vector<string> field_values);
+
         // HasPolicy determines whether a model has the specified policy rule.
         bool HasPolicy(string sec, string p_type, vector<string> rule);
 
@@ -0,0 +1,47 @@
+/*
+* Copyright 2020 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#pragma once
+
+#include "pch.h"
+
+#include "./model_handles.h"
+
+ModelHandles :: ModelHandles() {
+    this->g = NULL;
+    this->p_eft_index = -1;
+}
+
+// Resolve looks the handles up in a model, it has to be called again whenever the definitions of the model change.
+void ModelHandles :: Resolve(Model* model) {
+    this->r = model->m["r"].assertion_map["r"];
+    this->p = model->m["p"].assertion_map["p"];
+    this->e = model->m["e"].assertion_map["e"];
+    this->m = model->m["m"].assertion_map["m"];
+
+    this->g = NULL;
+    if(model->m.find("g") != model->m.end())
+        this->g = &(model->m["g"].assertion_map);
+
+    this->r_keys.clear();
+    for(int i = 0 ; i < this->r->tokens.size() ; i++)
+        this->r_keys.push_back(this->r->tokens[i].substr(2, this->r->tokens[i].size() - 2));
+
+    this->p_eft_index = -1;
+    for(int i = 0 ; i < this->p->tokens.size() ; i++){
+        if(this->p->tokens[i] == "p_eft")
+            this->p_eft_index = i;
+    }
+}
@@ -0,0 +1,50 @@
+/*
+* Copyright 2020 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef CASBIN_CPP_MODEL_MODEL_HANDLES
+#define CASBIN_CPP_MODEL_MODEL_HANDLES
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "./model.h"
+
+using namespace std;
+
+// ModelHandles are the parts of a model that every enforce call needs: the assertions of the request, policy, effect
+// and matcher definitions, the names of the request fields and the position of p_eft. They are resolved once when
+// the model is set, so that enforce calls do not look them up by name.
+class ModelHandles {
+    public:
+        shared_ptr<Assertion> r;
+        shared_ptr<Assertion> p;
+        shared_ptr<Assertion> e;
+        shared_ptr<Assertion> m;
+        // g are the role definitions, NULL if the model has none.
+        unordered_map<string, shared_ptr<Assertion>>* g;
+        // r_keys are the names of the request fields without the "r_" prefix.
+        vector<string> r_keys;
+        // p_eft_index is the position of p_eft in the policy definition, -1 if the rules have no effect.
+        int p_eft_index;
+
+        ModelHandles();
+
+        // Resolve looks the handles up in a model, it has to be called again whenever the definitions of the model change.
+        void Resolve(Model* model);
+};
+
+#endif
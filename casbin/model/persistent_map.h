@@ -0,0 +1,335 @@
+/*
+* Copyright 2020 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef CASBIN_CPP_MODEL_PERSISTENT_MAP
+#define CASBIN_CPP_MODEL_PERSISTENT_MAP
+
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "./persistent_vector.h"
+
+using namespace std;
+
+// PersistentMap is a hash map whose copies share its entries. It is a trie of the bits of the hashes of the keys,
+// 5 bits per level, so a change copies only the nodes on the path to its key that belong to another copy, and a copy
+// takes constant time. A map and its copies can be changed independently, but neither while the other is being copied.
+template<typename K, typename V, typename Hash = hash<K>>
+class PersistentMap {
+    private:
+        static const int level_bits = 5;
+        static const int hash_bits = int(sizeof(size_t) * 8);
+
+        class Node;
+
+        // Entry is a key with its value, or if child is not NULL, the node of the keys whose hashes have the same bits so far.
+        class Entry {
+            public:
+                size_t hash;
+                K key;
+                V value;
+                shared_ptr<Node> child;
+        };
+
+        // Node holds an entry for each value of the bits of its level that some hash has, in the order of these values.
+        // Below the last level, the node holds the entries of keys with the same hash in any order.
+        class Node {
+            public:
+                unsigned long owner;
+                unsigned int bitmap;
+                vector<Entry> entries;
+        };
+
+        shared_ptr<Node> root;
+        int size;
+        // owner is the ID of the nodes the map changes in place, it is replaced when the map is copied.
+        mutable unsigned long owner;
+
+        Node* Own(shared_ptr<Node>& node);
+
+        void Erase(shared_ptr<Node>& node, const K& key, size_t hash, int shift);
+
+    public:
+
+        // Iterator visits the entries of a map in the order of the bits of their hashes. It keeps the path from the root
+        // to the current entry, a level of the trie per hash_bits / level_bits + 1 bits and the level of equal hashes.
+        class Iterator {
+            private:
+                static const int max_depth = hash_bits / level_bits + 2;
+
+                const Node* nodes[max_depth];
+                int positions[max_depth];
+                int depth;
+                int remaining;
+
+                // Settle moves down from the current position to the next entry that holds a key.
+                void Settle() {
+                    while (this->remaining > 0) {
+                        const Node* node = this->nodes[this->depth];
+                        if (this->positions[this->depth] == node->entries.size()) {
+                            this->depth--;
+                            this->positions[this->depth]++;
+                            continue;
+                        }
+                        const Entry& entry = node->entries[this->positions[this->depth]];
+                        if (entry.child == NULL)
+                            return;
+                        this->depth++;
+                        this->nodes[this->depth] = entry.child.get();
+                        this->positions[this->depth] = 0;
+                    }
+                }
+
+            public:
+
+                Iterator(const Node* root, int size) {
+                    this->depth = 0;
+                    this->remaining = size;
+                    this->nodes[0] = root;
+                    this->positions[0] = 0;
+                    this->Settle();
+                }
+
+                const K& Key() const {
+                    return this->nodes[this->depth]->entries[this->positions[this->depth]].key;
+                }
+
+                const V& Value() const {
+                    return this->nodes[this->depth]->entries[this->positions[this->depth]].value;
+                }
+
+                Iterator& operator++() {
+                    this->remaining--;
+                    this->positions[this->depth]++;
+                    this->Settle();
+                    return *this;
+                }
+
+                bool operator!=(const Iterator& other) const {
+                    return this->remaining != other.remaining;
+                }
+        };
+
+        PersistentMap();
+
+        // The copy shares the nodes, both maps copy a node before they change it.
+        PersistentMap(const PersistentMap& other);
+
+        PersistentMap& operator=(const PersistentMap& other);
+
+        int Size() const;
+
+        // Find returns the value of key, NULL if the key is not in the map.
+        const V* Find(const K& key) const;
+
+        // Insert returns the value of key, a default value is added if the key is not in the map.
+        // The reference is valid until the map is changed again.
+        V& Insert(const K& key);
+
+        // Erase removes key, it returns false if the key is not in the map.
+        bool Erase(const K& key);
+
+        Iterator begin() const {
+            return Iterator(this->root.get(), this->size);
+        }
+
+        Iterator end() const {
+            return Iterator(this->root.get(), 0);
+        }
+};
+
+template<typename K, typename V, typename Hash>
+PersistentMap<K, V, Hash> :: PersistentMap() {
+    this->size = 0;
+    this->owner = NewPersistentOwner();
+}
+
+// The copy shares the nodes, both maps copy a node before they change it.
+template<typename K, typename V, typename Hash>
+PersistentMap<K, V, Hash> :: PersistentMap(const PersistentMap& other) : root(other.root) {
+    this->size = other.size;
+    this->owner = NewPersistentOwner();
+    other.owner = NewPersistentOwner();
+}
+
+template<typename K, typename V, typename Hash>
+PersistentMap<K, V, Hash>& PersistentMap<K, V, Hash> :: operator=(const PersistentMap& other) {
+    if (this == &other)
+        return *this;
+    this->root = other.root;
+    this->size = other.size;
+    this->owner = NewPersistentOwner();
+    other.owner = NewPersistentOwner();
+    return *this;
+}
+
+// Own returns node for a change, it is copied first if it belongs to another map.
+template<typename K, typename V, typename Hash>
+typename PersistentMap<K, V, Hash> :: Node* PersistentMap<K, V, Hash> :: Own(shared_ptr<Node>& node) {
+    if (node->owner != this->owner) {
+        node = shared_ptr<Node>(new Node(*node));
+        node->owner = this->owner;
+    }
+    return node.get();
+}
+
+template<typename K, typename V, typename Hash>
+int PersistentMap<K, V, Hash> :: Size() const {
+    return this->size;
+}
+
+// Find returns the value of key, NULL if the key is not in the map.
+template<typename K, typename V, typename Hash>
+const V* PersistentMap<K, V, Hash> :: Find(const K& key) const {
+    size_t hash = Hash()(key);
+    const Node* node = this->root.get();
+    for (int shift = 0 ; node != NULL ; shift += level_bits) {
+        if (shift >= hash_bits) {
+            for (int k = 0 ; k < node->entries.size() ; k++) {
+                if (node->entries[k].hash == hash && node->entries[k].key == key)
+                    return &node->entries[k].value;
+            }
+            return NULL;
+        }
+
+        unsigned int bit = 1u << ((hash >> shift) & 31);
+        if ((node->bitmap & bit) == 0)
+            return NULL;
+        const Entry& entry = node->entries[__builtin_popcount(node->bitmap & (bit - 1))];
+        if (entry.child == NULL)
+            return entry.hash == hash && entry.key == key ? &entry.value : NULL;
+        node = entry.child.get();
+    }
+    return NULL;
+}
+
+// Insert returns the value of key, a default value is added if the key is not in the map.
+// The reference is valid until the map is changed again.
+template<typename K, typename V, typename Hash>
+V& PersistentMap<K, V, Hash> :: Insert(const K& key) {
+    size_t hash = Hash()(key);
+    if (this->root == NULL) {
+        this->root = shared_ptr<Node>(new Node());
+        this->root->owner = this->owner;
+        this->root->bitmap = 0;
+    }
+
+    Node* node = this->Own(this->root);
+    for (int shift = 0 ; ; shift += level_bits) {
+        if (shift >= hash_bits) {
+            for (int k = 0 ; k < node->entries.size() ; k++) {
+                if (node->entries[k].hash == hash && node->entries[k].key == key)
+                    return node->entries[k].value;
+            }
+            Entry added;
+            added.hash = hash;
+            added.key = key;
+            added.value = V();
+            node->entries.push_back(added);
+            this->size++;
+            return node->entries.back().value;
+        }
+
+        unsigned int bit = 1u << ((hash >> shift) & 31);
+        int position = __builtin_popcount(node->bitmap & (bit - 1));
+        if ((node->bitmap & bit) == 0) {
+            Entry added;
+            added.hash = hash;
+            added.key = key;
+            added.value = V();
+            node->entries.insert(node->entries.begin() + position, added);
+            node->bitmap |= bit;
+            this->size++;
+            return node->entries[position].value;
+        }
+
+        Entry& entry = node->entries[position];
+        if (entry.child != NULL) {
+            node = this->Own(entry.child);
+            continue;
+        }
+        if (entry.hash == hash && entry.key == key)
+            return entry.value;
+
+        // Another key has the same bits so far, it moves down into a node of the next level, where the keys are compared again.
+        shared_ptr<Node> child(new Node());
+        child->owner = this->owner;
+        child->bitmap = shift + level_bits >= hash_bits ? 0 : 1u << ((entry.hash >> (shift + level_bits)) & 31);
+        Entry moved;
+        moved.hash = entry.hash;
+        moved.key = move(entry.key);
+        moved.value = move(entry.value);
+        child->entries.push_back(moved);
+        entry.key = K();
+        entry.value = V();
+        entry.child = child;
+        node = child.get();
+    }
+}
+
+// Erase removes key, it returns false if the key is not in the map.
+template<typename K, typename V, typename Hash>
+bool PersistentMap<K, V, Hash> :: Erase(const K& key) {
+    if (this->Find(key) == NULL)
+        return false;
+
+    this->Erase(this->root, key, Hash()(key), 0);
+    if (--this->size == 0)
+        this->root.reset();
+    return true;
+}
+
+// Erase removes key from the subtree of node, the key is in it.
+// A node that is left with a single key is merged into its parent, so the path to a key stays as short as at insertion.
+template<typename K, typename V, typename Hash>
+void PersistentMap<K, V, Hash> :: Erase(shared_ptr<Node>& node, const K& key, size_t hash, int shift) {
+    Node* owned = this->Own(node);
+    if (shift >= hash_bits) {
+        for (int k = 0 ; k < owned->entries.size() ; k++) {
+            if (owned->entries[k].hash == hash && owned->entries[k].key == key) {
+                owned->entries.erase(owned->entries.begin() + k);
+                return;
+            }
+        }
+        return;
+    }
+
+    unsigned int bit = 1u << ((hash >> shift) & 31);
+    int position = __builtin_popcount(owned->bitmap & (bit - 1));
+    Entry& entry = owned->entries[position];
+    if (entry.child == NULL) {
+        owned->entries.erase(owned->entries.begin() + position);
+        owned->bitmap &= ~bit;
+        return;
+    }
+
+    this->Erase(entry.child, key, hash, shift + level_bits);
+    Node* child = entry.child.get();
+    if (child->entries.empty()) {
+        owned->entries.erase(owned->entries.begin() + position);
+        owned->bitmap &= ~bit;
+    } else if (child->entries.size() == 1 && child->entries[0].child == NULL) {
+        Entry& last = child->entries[0];
+        entry.hash = last.hash;
+        entry.key = move(last.key);
+        entry.value = move(last.value);
+        entry.child.reset();
+    }
+}
+
+#endif
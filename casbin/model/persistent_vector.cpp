@@ -0,0 +1,29 @@
+/*
+* Copyright 2020 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "pch.h"
+
+#include <atomic>
+
+#include "./persistent_vector.h"
+
+// NewPersistentOwner returns an owner ID that no other copy of a persistent structure has.
+unsigned long NewPersistentOwner() {
+    static atomic<unsigned long> next_owner(1);
+    return next_owner.fetch_add(1, memory_order_relaxed);
+}
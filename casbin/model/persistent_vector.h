@@ -0,0 +1,155 @@
+/*
+* Copyright 2020 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef CASBIN_CPP_MODEL_PERSISTENT_VECTOR
+#define CASBIN_CPP_MODEL_PERSISTENT_VECTOR
+
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+// NewPersistentOwner returns an owner ID that no other copy of a persistent structure has.
+// A copy changes in place only the parts that carry its own ID, the other parts are shared with other copies and copied first.
+unsigned long NewPersistentOwner();
+
+// PersistentVector is a vector whose copies share its elements. The elements are stored in chunks, a change copies
+// the chunk it is in unless the chunk belongs to the vector, so a copy takes time in the number of chunks, not of elements.
+// A vector and its copies can be changed independently, but neither while the other is being copied.
+template<typename T>
+class PersistentVector {
+    private:
+        static const int chunk_bits = 10;
+        static const int chunk_size = 1 << chunk_bits;
+        static const int chunk_mask = chunk_size - 1;
+
+        // Chunk holds chunk_size elements, the elements after the end of the vector are unused.
+        class Chunk {
+            public:
+                unsigned long owner;
+                T values[chunk_size];
+        };
+
+        vector<shared_ptr<Chunk>> chunks;
+        int size;
+        // owner is the ID of the chunks the vector changes in place, it is replaced when the vector is copied.
+        mutable unsigned long owner;
+
+        Chunk* Own(int c);
+
+    public:
+
+        PersistentVector();
+
+        // The copy shares the chunks, both vectors copy a chunk before they change it.
+        PersistentVector(const PersistentVector& other);
+
+        PersistentVector& operator=(const PersistentVector& other);
+
+        int Size() const;
+
+        const T& operator[](int i) const;
+
+        // Set replaces the i-th element.
+        void Set(int i, const T& value);
+
+        void PushBack(const T& value);
+
+        void Clear();
+
+        // MemoryUsage returns the number of bytes allocated for the elements, including the chunks shared with other vectors.
+        size_t MemoryUsage() const;
+};
+
+template<typename T>
+PersistentVector<T> :: PersistentVector() {
+    this->size = 0;
+    this->owner = NewPersistentOwner();
+}
+
+// The copy shares the chunks, both vectors copy a chunk before they change it.
+template<typename T>
+PersistentVector<T> :: PersistentVector(const PersistentVector& other) : chunks(other.chunks) {
+    this->size = other.size;
+    this->owner = NewPersistentOwner();
+    other.owner = NewPersistentOwner();
+}
+
+template<typename T>
+PersistentVector<T>& PersistentVector<T> :: operator=(const PersistentVector& other) {
+    if (this == &other)
+        return *this;
+    this->chunks = other.chunks;
+    this->size = other.size;
+    this->owner = NewPersistentOwner();
+    other.owner = NewPersistentOwner();
+    return *this;
+}
+
+// Own returns the c-th chunk for a change, it is copied first if it belongs to another vector.
+template<typename T>
+typename PersistentVector<T> :: Chunk* PersistentVector<T> :: Own(int c) {
+    Chunk* chunk = this->chunks[c].get();
+    if (chunk->owner != this->owner) {
+        shared_ptr<Chunk> copy(new Chunk(*chunk));
+        copy->owner = this->owner;
+        this->chunks[c] = copy;
+        chunk = copy.get();
+    }
+    return chunk;
+}
+
+template<typename T>
+int PersistentVector<T> :: Size() const {
+    return this->size;
+}
+
+template<typename T>
+const T& PersistentVector<T> :: operator[](int i) const {
+    return this->chunks[i >> chunk_bits]->values[i & chunk_mask];
+}
+
+// Set replaces the i-th element.
+template<typename T>
+void PersistentVector<T> :: Set(int i, const T& value) {
+    this->Own(i >> chunk_bits)->values[i & chunk_mask] = value;
+}
+
+template<typename T>
+void PersistentVector<T> :: PushBack(const T& value) {
+    int c = this->size >> chunk_bits;
+    if (c == this->chunks.size()) {
+        shared_ptr<Chunk> chunk(new Chunk());
+        chunk->owner = this->owner;
+        this->chunks.push_back(chunk);
+    }
+    this->Own(c)->values[this->size & chunk_mask] = value;
+    this->size++;
+}
+
+template<typename T>
+void PersistentVector<T> :: Clear() {
+    this->chunks.clear();
+    this->size = 0;
+}
+
+// MemoryUsage returns the number of bytes allocated for the elements, including the chunks shared with other vectors.
+template<typename T>
+size_t PersistentVector<T> :: MemoryUsage() const {
+    return this->chunks.capacity() * sizeof(shared_ptr<Chunk>) + this->chunks.size() * sizeof(Chunk);
+}
+
+#endif
@@ -0,0 +1,103 @@
+/*
+* Copyright 2020 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "pch.h"
+
+#include "./policy_columns.h"
+
+// Size returns the number of rules.
+int PolicyColumns :: Size() const {
+    return this->sizes.Size();
+}
+
+// Width returns the number of columns, the number of values of the widest rule.
+int PolicyColumns :: Width() const {
+    return int(this->columns.size());
+}
+
+// RuleSize returns the number of values of the i-th rule.
+int PolicyColumns :: RuleSize(int i) const {
+    int size = this->sizes[i];
+    return size < 0 ? -1 - size : size;
+}
+
+// At returns the symbol of the i-th rule in the j-th column, -1 if the rule is shorter.
+int PolicyColumns :: At(int i, int j) const {
+    return this->columns[j][i];
+}
+
+// Rule returns a copy of the symbols of the i-th rule.
+vector<int> PolicyColumns :: Rule(int i) const {
+    vector<int> rule(this->RuleSize(i));
+    for(int j = 0 ; j < rule.size() ; j++)
+        rule[j] = this->columns[j][i];
+    return rule;
+}
+
+// Append appends a rule.
+void PolicyColumns :: Append(const vector<int>& rule) {
+    // A rule wider than the others adds columns, which hold -1 for the rules before it.
+    while(this->columns.size() < rule.size()) {
+        this->columns.push_back(PersistentVector<int>());
+        for(int i = 0 ; i < this->sizes.Size() ; i++)
+            this->columns.back().PushBack(-1);
+    }
+
+    for(int j = 0 ; j < this->columns.size() ; j++)
+        this->columns[j].PushBack(j < rule.size() ? rule[j] : -1);
+    this->sizes.PushBack(int(rule.size()));
+}
+
+// Remove marks the i-th rule as removed.
+void PolicyColumns :: Remove(int i) {
+    if(!this->IsRemoved(i))
+        this->sizes.Set(i, -1 - this->sizes[i]);
+}
+
+// IsRemoved returns true if the i-th rule has been removed.
+bool PolicyColumns :: IsRemoved(int i) const {
+    return this->sizes[i] < 0;
+}
+
+// Compact moves every rule to positions[i], in the same order, and drops the rules whose position is -1.
+// The kept rules are copied into new columns, which share nothing with the copies of the old ones.
+void PolicyColumns :: Compact(const vector<int>& positions) {
+    for(int j = 0 ; j < this->columns.size() ; j++){
+        PersistentVector<int> column;
+        for(int i = 0 ; i < positions.size() ; i++){
+            if(positions[i] != -1)
+                column.PushBack(this->columns[j][i]);
+        }
+        this->columns[j] = column;
+    }
+
+    PersistentVector<int> sizes;
+    for(int i = 0 ; i < positions.size() ; i++){
+        if(positions[i] != -1)
+            sizes.PushBack(this->sizes[i]);
+    }
+    this->sizes = sizes;
+}
+
+// MemoryUsage returns the number of bytes allocated for the rules.
+size_t PolicyColumns :: MemoryUsage() const {
+    size_t bytes = sizeof(PolicyColumns) + this->sizes.MemoryUsage() + this->columns.capacity() * sizeof(PersistentVector<int>);
+    for(int j = 0 ; j < this->columns.size() ; j++)
+        bytes += this->columns[j].MemoryUsage();
+    return bytes;
+}
@@ -0,0 +1,71 @@
+/*
+* Copyright 2020 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef CASBIN_CPP_MODEL_POLICY_COLUMNS
+#define CASBIN_CPP_MODEL_POLICY_COLUMNS
+
+#include <vector>
+
+#include "./persistent_vector.h"
+
+using namespace std;
+
+// PolicyColumns stores the rules of a policy column by column: every column is an array with the symbol of each rule
+// in it, so a scan of a column reads adjacent memory and a rule takes no allocation of its own. The columns are
+// persistent vectors, so a copy shares them and a change copies only the chunks it touches.
+// Rules shorter than the widest one hold -1 in the columns they do not have.
+// A removed rule keeps its symbols until the columns are compacted, so the other rules keep their positions.
+class PolicyColumns {
+    private:
+        vector<PersistentVector<int>> columns;
+        // sizes holds the number of values of every rule, -1 minus the number for a removed rule,
+        // so a scan that reads the size of a rule finds out whether it was removed from the same memory.
+        PersistentVector<int> sizes;
+
+    public:
+
+        // Size returns the number of rules.
+        int Size() const;
+
+        // Width returns the number of columns, the number of values of the widest rule.
+        int Width() const;
+
+        // RuleSize returns the number of values of the i-th rule.
+        int RuleSize(int i) const;
+
+        // At returns the symbol of the i-th rule in the j-th column, -1 if the rule is shorter.
+        int At(int i, int j) const;
+
+        // Rule returns a copy of the symbols of the i-th rule.
+        vector<int> Rule(int i) const;
+
+        // Append appends a rule.
+        void Append(const vector<int>& rule);
+
+        // Remove marks the i-th rule as removed.
+        void Remove(int i);
+
+        // IsRemoved returns true if the i-th rule has been removed.
+        bool IsRemoved(int i) const;
+
+        // Compact moves every rule to positions[i], in the same order, and drops the rules whose position is -1.
+        void Compact(const vector<int>& positions);
+
+        // MemoryUsage returns the number of bytes allocated for the rules.
+        size_t MemoryUsage() const;
+};
+
+#endif
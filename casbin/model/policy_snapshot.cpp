@@ -0,0 +1,429 @@
+/*
+* Copyright 2020 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "pch.h"
+
+#include <algorithm>
+
+#include "./policy_snapshot.h"
+
+// RuleList creates an empty list.
+RuleList :: RuleList() {
+    this->runs = NULL;
+    this->first = 0;
+    this->count = 0;
+}
+
+// RuleList creates the list of the count positions from first on.
+RuleList :: RuleList(int first, int count) {
+    this->runs = NULL;
+    this->first = first;
+    this->count = count;
+}
+
+// RuleList creates the list of count positions held by the runs from the one that starts at first.
+RuleList :: RuleList(const PersistentVector<int>* runs, int first, int count) {
+    this->runs = runs;
+    this->first = first;
+    this->count = count;
+}
+
+// Size returns the number of positions in the list.
+int RuleList :: Size() const {
+    return this->count;
+}
+
+PolicySnapshot :: RuleRuns :: RuleRuns() {
+    this->first = -1;
+    this->last = -1;
+    this->count = 0;
+    this->free = 0;
+}
+
+// Add appends the i-th rule to the positions of key, i is after every rule in the index.
+template<typename Key, typename Hash>
+void PolicySnapshot :: RuleIndex<Key, Hash> :: Add(const Key& key, int i) {
+    RuleRuns& runs = this->keys.Insert(key);
+    if(runs.free == 0) {
+        // A run holds its capacity, the start of the next run and the positions.
+        int capacity = runs.count == 0 ? 1 : min(this->runs[runs.last] * 2, int(max_run));
+        int run = this->runs.Size();
+        this->runs.PushBack(capacity);
+        this->runs.PushBack(-1);
+        for(int k = 0 ; k < capacity ; k++)
+            this->runs.PushBack(-1);
+        if(runs.count == 0)
+            runs.first = run;
+        else
+            this->runs.Set(runs.last + 1, run);
+        runs.last = run;
+        runs.free = capacity;
+    }
+
+    this->runs.Set(runs.last + 2 + this->runs[runs.last] - runs.free, i);
+    runs.free--;
+    runs.count++;
+}
+
+// Find returns the positions of the rules with key.
+template<typename Key, typename Hash>
+RuleList PolicySnapshot :: RuleIndex<Key, Hash> :: Find(const Key& key) const {
+    const RuleRuns* runs = this->keys.Find(key);
+    if(runs == NULL)
+        return RuleList();
+    return RuleList(&this->runs, runs->first, runs->count);
+}
+
+PolicySnapshot :: PolicySnapshot(int rule_size, shared_ptr<SymbolTable> symbols) {
+    this->symbols = symbols;
+    this->rule_size = rule_size;
+    this->irregular_rules = 0;
+    this->removed_count = 0;
+}
+
+// The copy shares the rules and the indices, it copies the parts it changes, so the writer can keep them up to date.
+PolicySnapshot :: PolicySnapshot(const PolicySnapshot& other) : symbols(other.symbols), rules(other.rules), values(other.values), fingerprints(other.fingerprints) {
+    this->rule_size = other.rule_size;
+    this->irregular_rules = other.irregular_rules;
+    this->removed_count = other.removed_count;
+
+    lock_guard<mutex> guard(other.index_lock);
+    this->column_indices.resize(other.column_indices.size());
+    for(int j = 0 ; j < other.column_indices.size() ; j++){
+        shared_ptr<ColumnIndex> index = atomic_load(&other.column_indices[j]);
+        if(index != NULL)
+            this->column_indices[j] = shared_ptr<ColumnIndex>(new ColumnIndex(*index));
+    }
+    for(map<pair<int, int>, shared_ptr<PrefixIndex>> :: const_iterator it = other.prefix_indices.begin() ; it != other.prefix_indices.end() ; it++)
+        this->prefix_indices[it->first] = shared_ptr<PrefixIndex>(new PrefixIndex(*it->second));
+}
+
+// Rules returns the rules of the snapshot.
+const PolicyColumns& PolicySnapshot :: Rules() const {
+    return this->rules;
+}
+
+// Symbols returns the symbol table the values of the rules are interned in.
+const shared_ptr<SymbolTable>& PolicySnapshot :: Symbols() const {
+    return this->symbols;
+}
+
+// UsedSymbolCount returns the number of symbols the rules use, a symbol is counted once for every column it is in.
+int PolicySnapshot :: UsedSymbolCount() const {
+    int count = 0;
+    for(int j = 0 ; j < this->values.size() ; j++)
+        count += this->values[j].Size();
+    return count;
+}
+
+// Append appends a rule and adds it to the indices that have been built.
+void PolicySnapshot :: Append(const vector<int>& rule) {
+    int i = this->rules.Size();
+    this->live.reset();
+    this->rules.Append(rule);
+    if(rule.size() != this->rule_size)
+        this->irregular_rules++;
+
+    if(this->values.size() < rule.size())
+        this->values.resize(rule.size());
+    for(int j = 0 ; j < rule.size() ; j++)
+        this->values[j].Add(rule[j]);
+    this->fingerprints.Insert(Fingerprint(rule))++;
+
+    // The snapshot has not been published yet, so its indices are changed in place.
+    if(this->column_indices.size() < this->rules.Width())
+        this->column_indices.resize(this->rules.Width());
+    for(int j = 0 ; j < rule.size() ; j++){
+        if(this->column_indices[j] != NULL)
+            this->column_indices[j]->Add(rule[j], i);
+    }
+    for(map<pair<int, int>, shared_ptr<PrefixIndex>> :: iterator it = this->prefix_indices.begin() ; it != this->prefix_indices.end() ; it++){
+        int field_index = it->first.first;
+        int length = it->first.second;
+        if(field_index + length <= rule.size())
+            it->second->Add(vector<int>(rule.begin() + field_index, rule.begin() + field_index + length), i);
+    }
+}
+
+// Remove marks the i-th rule as removed. It is stored until the snapshot is compacted, so the other rules keep their positions.
+void PolicySnapshot :: Remove(int i) {
+    if(this->rules.IsRemoved(i))
+        return;
+    this->rules.Remove(i);
+    this->removed_count++;
+    this->live.reset();
+    if(this->rules.RuleSize(i) != this->rule_size)
+        this->irregular_rules--;
+
+    for(int j = 0 ; j < this->rules.RuleSize(i) ; j++)
+        this->values[j].Remove(this->rules.At(i, j));
+
+    vector<int> fingerprint = Fingerprint(this->rules.Rule(i));
+    if(--this->fingerprints.Insert(fingerprint) == 0)
+        this->fingerprints.Erase(fingerprint);
+}
+
+// IsRemoved returns true if the i-th rule has been removed.
+bool PolicySnapshot :: IsRemoved(int i) const {
+    return this->rules.IsRemoved(i);
+}
+
+// RemovedCount returns the number of removed rules that are still stored.
+int PolicySnapshot :: RemovedCount() const {
+    return this->removed_count;
+}
+
+// Fingerprint returns the sorted symbols of a rule, rules with the same values in any order have the same fingerprint like ArrayEquals compares them.
+vector<int> PolicySnapshot :: Fingerprint(vector<int> rule) {
+    sort(rule.begin(), rule.end());
+    return rule;
+}
+
+// CountRule returns the number of rules that have the symbols of rule in any order.
+int PolicySnapshot :: CountRule(const vector<int>& rule) const {
+    const int* count = this->fingerprints.Find(Fingerprint(rule));
+    return count == NULL ? 0 : *count;
+}
+
+// Compact drops the removed rules and keeps the order of the others, the indices that have been built are built again.
+void PolicySnapshot :: Compact() {
+    if(this->removed_count == 0)
+        return;
+
+    vector<int> positions(this->rules.Size());
+    int kept = 0;
+    for(int i = 0 ; i < positions.size() ; i++)
+        positions[i] = this->IsRemoved(i) ? -1 : kept++;
+    this->rules.Compact(positions);
+    this->removed_count = 0;
+    this->live.reset();
+
+    for(int j = 0 ; j < this->column_indices.size() ; j++){
+        if(this->column_indices[j] != NULL)
+            this->column_indices[j] = this->BuildColumnIndex(j);
+    }
+    for(map<pair<int, int>, shared_ptr<PrefixIndex>> :: iterator it = this->prefix_indices.begin() ; it != this->prefix_indices.end() ; it++)
+        it->second = this->BuildPrefixIndex(it->first.first, it->first.second);
+}
+
+// Reintern returns a compacted copy of the snapshot whose rules are interned in a new symbol table, so that the
+// values no rule has any more are freed with the old table once the snapshots that hold it are released.
+// The indices are built again when they are used.
+shared_ptr<PolicySnapshot> PolicySnapshot :: Reintern() const {
+    shared_ptr<PolicySnapshot> snapshot(new PolicySnapshot(this->rule_size, shared_ptr<SymbolTable>(new SymbolTable())));
+    vector<int> rule;
+    for(int i = 0 ; i < this->rules.Size() ; i++){
+        if(this->IsRemoved(i))
+            continue;
+        rule.resize(this->rules.RuleSize(i));
+        for(int j = 0 ; j < rule.size() ; j++)
+            rule[j] = snapshot->symbols->Intern(this->symbols->Value(this->rules.At(i, j)));
+        snapshot->Append(rule);
+    }
+    return snapshot;
+}
+
+// LivePositions returns the positions of the rules that have not been removed, in policy order,
+// or NULL if no rule has been removed. It is built on first use.
+shared_ptr<const vector<int>> PolicySnapshot :: LivePositions() const {
+    if(this->removed_count == 0)
+        return NULL;
+
+    shared_ptr<const vector<int>> live = atomic_load(&this->live);
+    if(live != NULL)
+        return live;
+
+    lock_guard<mutex> guard(this->index_lock);
+    live = atomic_load(&this->live);
+    if(live == NULL) {
+        shared_ptr<vector<int>> positions(new vector<int>());
+        positions->reserve(this->rules.Size() - this->removed_count);
+        for(int i = 0 ; i < this->rules.Size() ; i++){
+            if(!this->IsRemoved(i))
+                positions->push_back(i);
+        }
+        live = positions;
+        atomic_store(&this->live, live);
+    }
+    return live;
+}
+
+// DistinctValues returns the symbols in a column of the rules, each symbol once in the order it was first added.
+// It takes time in the number of distinct symbols, not in the number of rules.
+vector<int> PolicySnapshot :: DistinctValues(int column) const {
+    if(column < 0 || column >= this->values.size())
+        return vector<int>();
+    return this->values[column].Symbols();
+}
+
+PolicySnapshot :: ColumnValues :: ColumnValues() {
+    this->unused = 0;
+}
+
+void PolicySnapshot :: ColumnValues :: Add(int symbol) {
+    pair<int, int>& count = this->counts.Insert(symbol);
+    if(count.first++ > 0)
+        return;
+
+    count.second = this->order.Size();
+    this->order.PushBack(symbol);
+}
+
+void PolicySnapshot :: ColumnValues :: Remove(int symbol) {
+    pair<int, int>& count = this->counts.Insert(symbol);
+    if(--count.first > 0)
+        return;
+
+    this->counts.Erase(symbol);
+    this->unused++;
+    if(this->unused * 2 <= this->order.Size())
+        return;
+
+    // The unused slots are dropped once they are the majority, so that Symbols stays proportional to the used symbols.
+    PersistentVector<int> order;
+    for(int i = 0 ; i < this->order.Size() ; i++){
+        const pair<int, int>* used = this->counts.Find(this->order[i]);
+        if(used != NULL && used->second == i) {
+            this->counts.Insert(this->order[i]).second = order.Size();
+            order.PushBack(this->order[i]);
+        }
+    }
+    this->order = order;
+    this->unused = 0;
+}
+
+// Size returns the number of symbols that are used by some rule.
+int PolicySnapshot :: ColumnValues :: Size() const {
+    return this->counts.Size();
+}
+
+// Symbols returns the symbols that are used by some rule.
+vector<int> PolicySnapshot :: ColumnValues :: Symbols() const {
+    vector<int> symbols;
+    symbols.reserve(this->order.Size() - this->unused);
+    for(int i = 0 ; i < this->order.Size() ; i++){
+        if(this->unused == 0) {
+            symbols.push_back(this->order[i]);
+            continue;
+        }
+        const pair<int, int>* used = this->counts.Find(this->order[i]);
+        if(used != NULL && used->second == i)
+            symbols.push_back(this->order[i]);
+    }
+    return symbols;
+}
+
+// BuildColumnIndex builds the index of a column from the rules that have not been removed.
+// Rules that are shorter than the column hold -1 in it.
+shared_ptr<PolicySnapshot :: ColumnIndex> PolicySnapshot :: BuildColumnIndex(int column) const {
+    shared_ptr<ColumnIndex> index(new ColumnIndex());
+    for(int i = 0 ; i < this->rules.Size() ; i++){
+        int symbol = this->rules.At(i, column);
+        if(symbol != -1 && !this->IsRemoved(i))
+            index->Add(symbol, i);
+    }
+    return index;
+}
+
+// BuildPrefixIndex builds the index of length consecutive fields from field_index on, from the rules that have not been removed.
+shared_ptr<PolicySnapshot :: PrefixIndex> PolicySnapshot :: BuildPrefixIndex(int field_index, int length) const {
+    shared_ptr<PrefixIndex> index(new PrefixIndex());
+    vector<int> key(length);
+    for(int i = 0 ; i < this->rules.Size() ; i++){
+        if(field_index + length > this->rules.RuleSize(i) || this->IsRemoved(i))
+            continue;
+        for(int j = 0 ; j < length ; j++)
+            key[j] = this->rules.At(i, field_index + j);
+        index->Add(key, i);
+    }
+    return index;
+}
+
+// GetColumnIndex returns the index of a column that some rule has, it is built on first use.
+const PolicySnapshot :: ColumnIndex& PolicySnapshot :: GetColumnIndex(int column) const {
+    shared_ptr<ColumnIndex> index = atomic_load(&this->column_indices[column]);
+    if(index != NULL)
+        return *index;
+
+    lock_guard<mutex> guard(this->index_lock);
+    index = atomic_load(&this->column_indices[column]);
+    if(index == NULL) {
+        index = this->BuildColumnIndex(column);
+        atomic_store(&this->column_indices[column], index);
+    }
+    return *index;
+}
+
+// GetRulesByColumn looks up the positions, in policy order, of the rules that have the symbol in the column.
+// It returns false when some rule does not match the tokens, then every rule has to be checked.
+// Rules removed since the index was built are still among them.
+bool PolicySnapshot :: GetRulesByColumn(int column, int symbol, RuleList& rules) const {
+    if(column < 0 || column >= this->rule_size || this->irregular_rules > 0)
+        return false;
+
+    rules = this->GetRulesWithSymbol(column, symbol);
+    return true;
+}
+
+// GetRulesWithSymbol returns the positions, in policy order, of the rules of any size that have the symbol in the column.
+// Rules removed since the index was built are still among them.
+RuleList PolicySnapshot :: GetRulesWithSymbol(int column, int symbol) const {
+    if(column < 0 || column >= this->rules.Width())
+        return RuleList();
+    return this->GetColumnIndex(column).Find(symbol);
+}
+
+// GetRulesByFields looks up the positions, in policy order, of the rules that can have field_symbols from field_index on,
+// a symbol of -1 matches any value. The longest run of consecutive symbols is looked up in a composite index
+// of these fields, a single symbol in a column index, so the rules still have to be checked against the other symbols
+// and whether they have been removed. It returns false when every symbol is -1.
+bool PolicySnapshot :: GetRulesByFields(int field_index, const vector<int>& field_symbols, RuleList& rules) const {
+    int start = -1;
+    int length = 0;
+    for(int j = 0 ; j < field_symbols.size() ; ){
+        int k = j;
+        while(k < field_symbols.size() && field_symbols[k] != -1)
+            k++;
+        if(k - j > length){
+            start = j;
+            length = k - j;
+        }
+        j = k + 1;
+    }
+    if(length == 0 || field_index < 0)
+        return false;
+    if(field_index + start + length > this->rules.Width()) {
+        rules = RuleList();
+        return true;
+    }
+
+    if(length == 1){
+        rules = this->GetColumnIndex(field_index + start).Find(field_symbols[start]);
+        return true;
+    }
+
+    lock_guard<mutex> guard(this->index_lock);
+
+    pair<int, int> fields(field_index + start, length);
+    shared_ptr<PrefixIndex>& index = this->prefix_indices[fields];
+    if(index == NULL)
+        index = this->BuildPrefixIndex(fields.first, length);
+
+    rules = index->Find(vector<int>(field_symbols.begin() + start, field_symbols.begin() + start + length));
+    return true;
+}
@@ -0,0 +1,263 @@
+/*
+* Copyright 2020 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef CASBIN_CPP_MODEL_POLICY_SNAPSHOT
+#define CASBIN_CPP_MODEL_POLICY_SNAPSHOT
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "./persistent_map.h"
+#include "./policy_columns.h"
+#include "./symbol_table.h"
+
+using namespace std;
+
+// RuleList is a list of positions of rules of a snapshot in policy order: a range of positions, or the runs of an index
+// of the snapshot that hold the positions of the rules with a key. It is valid as long as the snapshot.
+class RuleList {
+    private:
+        // runs holds runs of consecutive positions, each one after its capacity and the start of the next run, NULL for a range.
+        const PersistentVector<int>* runs;
+        int first;
+        int count;
+
+    public:
+
+        // Iterator walks the positions of a list, it is defined here so that the loops over the rules inline it.
+        class Iterator {
+            private:
+                const PersistentVector<int>* runs;
+                int run;
+                int position;
+                int run_end;
+                int remaining;
+
+            public:
+
+                Iterator(const PersistentVector<int>* runs, int first, int count) {
+                    this->runs = runs;
+                    this->remaining = count;
+                    this->run = first;
+                    this->position = first;
+                    this->run_end = 0;
+                    if(runs != NULL && count > 0) {
+                        this->position = first + 2;
+                        this->run_end = this->position + (*runs)[first];
+                    }
+                }
+
+                int operator*() const {
+                    return this->runs == NULL ? this->position : (*this->runs)[this->position];
+                }
+
+                Iterator& operator++() {
+                    this->remaining--;
+                    this->position++;
+                    if(this->runs != NULL && this->position == this->run_end && this->remaining > 0) {
+                        this->run = (*this->runs)[this->run + 1];
+                        this->position = this->run + 2;
+                        this->run_end = this->position + (*this->runs)[this->run];
+                    }
+                    return *this;
+                }
+
+                bool operator!=(const Iterator& other) const {
+                    return this->remaining != other.remaining;
+                }
+        };
+
+        // RuleList creates an empty list.
+        RuleList();
+
+        // RuleList creates the list of the count positions from first on.
+        RuleList(int first, int count);
+
+        // RuleList creates the list of count positions held by the runs from the one that starts at first.
+        RuleList(const PersistentVector<int>* runs, int first, int count);
+
+        // Size returns the number of positions in the list.
+        int Size() const;
+
+        Iterator begin() const {
+            return Iterator(this->runs, this->first, this->count);
+        }
+
+        Iterator end() const {
+            return Iterator(this->runs, this->first, 0);
+        }
+};
+
+// PolicySnapshot is a version of the rules of an assertion together with their indices. A writer changes its own
+// copy and publishes it, after that it is never changed, so readers use it without locks while it is replaced.
+// The rules, the distinct values and the indices are persistent structures, so the copy of a writer shares them
+// with the published version and a change copies only the parts it touches.
+// The indices are still built on first use: a column index is published with an atomic store once it is complete.
+class PolicySnapshot {
+    private:
+        // RuleRuns locates the runs that hold the positions of the rules with a key: the first and the last run,
+        // the number of positions and the number of free slots of the last run.
+        class RuleRuns {
+            public:
+                int first;
+                int last;
+                int count;
+                int free;
+
+                RuleRuns();
+        };
+
+        // RuleIndex maps a key to the positions of the rules with it, in policy order. The positions of a key are stored
+        // in runs that double in size, so they are read from adjacent memory and a new rule only writes to the last run.
+        template<typename Key, typename Hash>
+        class RuleIndex {
+            public:
+                static const int max_run = 1024;
+
+                PersistentMap<Key, RuleRuns, Hash> keys;
+                PersistentVector<int> runs;
+
+                // Add appends the i-th rule to the positions of key, i is after every rule in the index.
+                void Add(const Key& key, int i);
+
+                // Find returns the positions of the rules with key.
+                RuleList Find(const Key& key) const;
+        };
+
+        typedef RuleIndex<int, hash<int>> ColumnIndex;
+        typedef RuleIndex<vector<int>, SymbolsHash> PrefixIndex;
+
+        // ColumnValues counts the rules by the symbol in a column, the symbols are kept in the order they were added.
+        // A symbol that is no longer used leaves an unused slot in the order, it is added at the end if it is used again.
+        class ColumnValues {
+            private:
+                // counts maps a symbol to the number of rules with it and its slot in order.
+                PersistentMap<int, pair<int, int>> counts;
+                PersistentVector<int> order;
+                int unused;
+
+            public:
+                ColumnValues();
+
+                void Add(int symbol);
+
+                void Remove(int symbol);
+
+                // Symbols returns the symbols that are used by some rule.
+                vector<int> Symbols() const;
+
+                // Size returns the number of symbols that are used by some rule.
+                int Size() const;
+        };
+
+        // symbols is the table the values of the rules are interned in, the drafts of the snapshot intern new values in it
+        // and a snapshot that is cleared or interned again starts a new one.
+        shared_ptr<SymbolTable> symbols;
+
+        // rule_size is the number of tokens of the assertion, irregular_rules counts the rules of another size.
+        int rule_size;
+        int irregular_rules;
+        PolicyColumns rules;
+        // removed_count counts the rules that have been removed but are still stored.
+        int removed_count;
+        // live holds the positions of the rules that have not been removed, NULL until it is built.
+        mutable shared_ptr<const vector<int>> live;
+        // values are the distinct symbols of every column, they are kept up to date when rules are appended and removed.
+        vector<ColumnValues> values;
+        // fingerprints counts the rules by their sorted symbols, so a rule is found in constant time.
+        PersistentMap<vector<int>, int, SymbolsHash> fingerprints;
+
+        // column_indices maps a column to the positions of the rules by the symbol in the column, NULL until it is built,
+        // prefix_indices maps consecutive fields, as (field index, length), to the positions of the rules by the symbols in them.
+        mutable vector<shared_ptr<ColumnIndex>> column_indices;
+        mutable map<pair<int, int>, shared_ptr<PrefixIndex>> prefix_indices;
+        // index_lock serializes building the indices and guards prefix_indices.
+        mutable mutex index_lock;
+
+        const ColumnIndex& GetColumnIndex(int column) const;
+
+        shared_ptr<ColumnIndex> BuildColumnIndex(int column) const;
+
+        shared_ptr<PrefixIndex> BuildPrefixIndex(int field_index, int length) const;
+
+    public:
+
+        PolicySnapshot(int rule_size, shared_ptr<SymbolTable> symbols);
+
+        // The copy shares the rules and the indices, it copies the parts it changes, so the writer can keep them up to date.
+        PolicySnapshot(const PolicySnapshot& other);
+
+        // Rules returns the rules of the snapshot.
+        const PolicyColumns& Rules() const;
+
+        // Symbols returns the symbol table the values of the rules are interned in.
+        const shared_ptr<SymbolTable>& Symbols() const;
+
+        // UsedSymbolCount returns the number of symbols the rules use, a symbol is counted once for every column it is in.
+        int UsedSymbolCount() const;
+
+        // Append appends a rule and adds it to the indices that have been built.
+        void Append(const vector<int>& rule);
+
+        // Remove marks the i-th rule as removed. It is stored until the snapshot is compacted, so the other rules keep their positions.
+        void Remove(int i);
+
+        // IsRemoved returns true if the i-th rule has been removed.
+        bool IsRemoved(int i) const;
+
+        // RemovedCount returns the number of removed rules that are still stored.
+        int RemovedCount() const;
+
+        // Fingerprint returns the sorted symbols of a rule, rules with the same values in any order have the same fingerprint like ArrayEquals compares them.
+        static vector<int> Fingerprint(vector<int> rule);
+
+        // CountRule returns the number of rules that have the symbols of rule in any order.
+        int CountRule(const vector<int>& rule) const;
+
+        // Compact drops the removed rules and keeps the order of the others, the indices that have been built are built again.
+        void Compact();
+
+        // Reintern returns a compacted copy of the snapshot whose rules are interned in a new symbol table, so that the
+        // values no rule has any more are freed with the old table once the snapshots that hold it are released.
+        // The indices are built again when they are used.
+        shared_ptr<PolicySnapshot> Reintern() const;
+
+        // LivePositions returns the positions of the rules that have not been removed, in policy order,
+        // or NULL if no rule has been removed. It is built on first use.
+        shared_ptr<const vector<int>> LivePositions() const;
+
+        // DistinctValues returns the symbols in a column of the rules, each symbol once in the order it was first added.
+        // It takes time in the number of distinct symbols, not in the number of rules.
+        vector<int> DistinctValues(int column) const;
+
+        // GetRulesByColumn looks up the positions, in policy order, of the rules that have the symbol in the column.
+        // It returns false when some rule does not match the tokens, then every rule has to be checked.
+        // Rules removed since the index was built are still among them.
+        bool GetRulesByColumn(int column, int symbol, RuleList& rules) const;
+
+        // GetRulesWithSymbol returns the positions, in policy order, of the rules of any size that have the symbol in the column.
+        // Rules removed since the index was built are still among them.
+        RuleList GetRulesWithSymbol(int column, int symbol) const;
+
+        // GetRulesByFields looks up the positions, in policy order, of the rules that can have field_symbols from field_index on,
+        // a symbol of -1 matches any value. The longest run of consecutive symbols is looked up in a composite index
+        // of these fields, a single symbol in a column index, so the rules still have to be checked against the other symbols
+        // and whether they have been removed. It returns false when every symbol is -1.
+        bool GetRulesByFields(int field_index, const vector<int>& field_symbols, RuleList& rules) const;
+};
+
+#endif
@@ -0,0 +1,198 @@
+/*
+* Copyright 2020 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "pch.h"
+
+#include "./policy_view.h"
+
+PolicyView :: Rule :: Rule(const PolicyColumns* rules, int i, const SymbolTable* symbols) {
+    this->rules = rules;
+    this->i = i;
+    this->symbols = symbols;
+}
+
+int PolicyView :: Rule :: Size() const {
+    return this->rules->RuleSize(this->i);
+}
+
+const string& PolicyView :: Rule :: operator[](int j) const {
+    return this->symbols->Value(this->rules->At(this->i, j));
+}
+
+// Symbol returns the symbol of the j-th value of the rule.
+int PolicyView :: Rule :: Symbol(int j) const {
+    return this->rules->At(this->i, j);
+}
+
+// Symbols returns a copy of the symbols of the values of the rule.
+vector<int> PolicyView :: Rule :: Symbols() const {
+    return this->rules->Rule(this->i);
+}
+
+// Values returns a copy of the values of the rule.
+vector<string> PolicyView :: Rule :: Values() const {
+    return this->symbols->ValuesOf(this->rules->Rule(this->i));
+}
+
+PolicyView :: Iterator :: Iterator(const PolicyView* view, int i) {
+    this->view = view;
+    this->i = i;
+}
+
+PolicyView :: Rule PolicyView :: Iterator :: operator*() const {
+    return (*this->view)[this->i];
+}
+
+PolicyView :: Iterator& PolicyView :: Iterator :: operator++() {
+    this->i++;
+    return *this;
+}
+
+bool PolicyView :: Iterator :: operator!=(const Iterator& other) const {
+    return this->i != other.i || this->view != other.view;
+}
+
+PolicyView :: PolicyView() {
+    this->snapshot = shared_ptr<const PolicySnapshot>(new PolicySnapshot(0, shared_ptr<SymbolTable>(new SymbolTable())));
+    this->rules = &this->snapshot->Rules();
+    this->filtered = false;
+    this->symbols = this->snapshot->Symbols();
+}
+
+// The values of the rules are read from the symbol table of the snapshot, it is kept alive with the snapshot.
+PolicyView :: PolicyView(shared_ptr<const PolicySnapshot> snapshot) {
+    this->snapshot = snapshot;
+    this->rules = &snapshot->Rules();
+    this->selection = snapshot->LivePositions();
+    this->filtered = false;
+    this->symbols = snapshot->Symbols();
+}
+
+int PolicyView :: Size() const {
+    return this->selection == NULL ? this->rules->Size() : int(this->selection->size());
+}
+
+PolicyView :: Rule PolicyView :: operator[](int i) const {
+    return Rule(this->rules, this->Index(i), this->symbols.get());
+}
+
+// Index returns the position of the i-th rule of the view in the policy it was taken from.
+int PolicyView :: Index(int i) const {
+    return this->selection == NULL ? i : (*this->selection)[i];
+}
+
+// Positions returns the positions of every rule stored in the snapshot of the view, the removed rules included.
+RuleList PolicyView :: Positions() const {
+    return RuleList(0, this->rules->Size());
+}
+
+// IsRemoved returns true if the rule at a position of the snapshot has been removed.
+bool PolicyView :: IsRemoved(int position) const {
+    return this->rules->IsRemoved(position);
+}
+
+// RuleAt returns the rule at a position of the snapshot.
+PolicyView :: Rule PolicyView :: RuleAt(int position) const {
+    return Rule(this->rules, position, this->symbols.get());
+}
+
+// Symbols returns the symbol table the values of the rules are interned in, the symbols of a request have to be looked up in it.
+const SymbolTable& PolicyView :: Symbols() const {
+    return *this->symbols;
+}
+
+PolicyView :: Iterator PolicyView :: begin() const {
+    return Iterator(this, 0);
+}
+
+PolicyView :: Iterator PolicyView :: end() const {
+    return Iterator(this, this->Size());
+}
+
+// FindFieldSymbols looks the filter values up in the symbol table, an empty value matches any value and gets the symbol -1.
+// It returns false when a value is not in the symbol table, then it cannot match any rule.
+bool PolicyView :: FindFieldSymbols(const SymbolTable& symbols, const vector<string>& field_values, vector<int>& field_symbols) {
+    field_symbols.assign(field_values.size(), -1);
+    for (int j = 0 ; j < field_values.size() ; j++) {
+        if (field_values[j] == "")
+            continue;
+        field_symbols[j] = symbols.Find(field_values[j]);
+        if (field_symbols[j] == -1)
+            return false;
+    }
+    return true;
+}
+
+// Filter returns a view of the rules that have field_values from field_index on, an empty value matches any value.
+// The candidate rules of a view that holds every rule are looked up in the indices of the snapshot.
+PolicyView PolicyView :: Filter(int field_index, const vector<string>& field_values) const {
+    vector<int> field_symbols;
+    RuleList candidates;
+    if (!FindFieldSymbols(*this->symbols, field_values, field_symbols))
+        return this->Select(field_index, field_symbols, &candidates);
+    if (this->filtered || !this->snapshot->GetRulesByFields(field_index, field_symbols, candidates))
+        return this->Select(field_index, field_symbols, NULL);
+    return this->Select(field_index, field_symbols, &candidates);
+}
+
+// GetRulesByColumn looks up the positions, in policy order, of the rules of the snapshot that have the symbol in the column.
+// It returns false when some rule does not match the tokens, then every rule has to be checked.
+// Removed rules can be among them.
+bool PolicyView :: GetRulesByColumn(int column, int symbol, RuleList& rules) const {
+    return this->snapshot->GetRulesByColumn(column, symbol, rules);
+}
+
+// Select returns a view of the rules that have field_symbols from field_index on, a symbol of -1 matches any value.
+// candidates are the positions in the policy of the only rules that can match, in policy order, or NULL to check every rule.
+// They are only used when the view is not filtered.
+PolicyView PolicyView :: Select(int field_index, const vector<int>& field_symbols, const RuleList* candidates) const {
+    shared_ptr<vector<int>> selection(new vector<int>());
+    PolicyView view(*this);
+    view.selection = selection;
+    view.filtered = true;
+
+    // Without candidates every rule of the view is checked, k is then its index in the view and not its position in the policy.
+    // The candidates come from the indices of the snapshot, which still hold the rules removed after they were built.
+    bool all = candidates == NULL || this->filtered;
+    RuleList rules = all ? RuleList(0, this->Size()) : *candidates;
+    for (RuleList :: Iterator it = rules.begin() ; it != rules.end() ; ++it) {
+        int k = *it;
+        int index = all ? this->Index(k) : k;
+        if (!all && this->snapshot->IsRemoved(index))
+            continue;
+        bool matched = true;
+        for (int j = 0 ; j < field_symbols.size() ; j++) {
+            if (field_symbols[j] != -1 && (field_index + j >= this->rules->Width() || this->rules->At(index, field_index + j) != field_symbols[j])) {
+                matched = false;
+                break;
+            }
+        }
+        if (matched)
+            selection->push_back(index);
+    }
+
+    return view;
+}
+
+// Values returns a copy of the values of the rules in the view.
+vector<vector<string>> PolicyView :: Values() const {
+    vector<vector<string>> values(this->Size());
+    for (int i = 0 ; i < this->Size() ; i++)
+        values[i] = (*this)[i].Values();
+    return values;
+}
@@ -0,0 +1,132 @@
+/*
+* Copyright 2020 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef CASBIN_CPP_MODEL_POLICY_VIEW
+#define CASBIN_CPP_MODEL_POLICY_VIEW
+
+#include <memory>
+#include <vector>
+
+#include "./policy_snapshot.h"
+
+using namespace std;
+
+// PolicyView is a read-only view of a snapshot of the rules of an assertion. The snapshot is kept alive by the view,
+// so a view is cheap to take and to filter, and it is not affected by later changes.
+class PolicyView {
+    private:
+        shared_ptr<const PolicySnapshot> snapshot;
+        const PolicyColumns* rules;
+        // selection holds the positions of the rules in the view, it is NULL when the view holds every rule.
+        // The selection of an unfiltered view skips the rules that have been removed but are still stored in the snapshot.
+        shared_ptr<const vector<int>> selection;
+        bool filtered;
+        shared_ptr<SymbolTable> symbols;
+
+    public:
+
+        // Rule is a rule of a view, its symbols are read from the columns and its values from the symbol table without copies.
+        class Rule {
+            private:
+                const PolicyColumns* rules;
+                int i;
+                const SymbolTable* symbols;
+
+            public:
+
+                Rule(const PolicyColumns* rules, int i, const SymbolTable* symbols);
+
+                int Size() const;
+
+                const string& operator[](int j) const;
+
+                // Symbol returns the symbol of the j-th value of the rule.
+                int Symbol(int j) const;
+
+                // Symbols returns a copy of the symbols of the values of the rule.
+                vector<int> Symbols() const;
+
+                // Values returns a copy of the values of the rule.
+                vector<string> Values() const;
+        };
+
+        class Iterator {
+            private:
+                const PolicyView* view;
+                int i;
+
+            public:
+
+                Iterator(const PolicyView* view, int i);
+
+                Rule operator*() const;
+
+                Iterator& operator++();
+
+                bool operator!=(const Iterator& other) const;
+        };
+
+        PolicyView();
+
+        // The values of the rules are read from the symbol table of the snapshot, it is kept alive with the snapshot.
+        PolicyView(shared_ptr<const PolicySnapshot> snapshot);
+
+        int Size() const;
+
+        Rule operator[](int i) const;
+
+        // Index returns the position of the i-th rule of the view in the policy it was taken from.
+        int Index(int i) const;
+
+        // Positions returns the positions of every rule stored in the snapshot of the view, the removed rules included.
+        RuleList Positions() const;
+
+        // IsRemoved returns true if the rule at a position of the snapshot has been removed.
+        bool IsRemoved(int position) const;
+
+        // RuleAt returns the rule at a position of the snapshot.
+        Rule RuleAt(int position) const;
+
+        // Symbols returns the symbol table the values of the rules are interned in, the symbols of a request have to be looked up in it.
+        const SymbolTable& Symbols() const;
+
+        Iterator begin() const;
+
+        Iterator end() const;
+
+        // Filter returns a view of the rules that have field_values from field_index on, an empty value matches any value.
+        // The candidate rules of a view that holds every rule are looked up in the indices of the snapshot.
+        PolicyView Filter(int field_index, const vector<string>& field_values) const;
+
+        // Select returns a view of the rules that have field_symbols from field_index on, a symbol of -1 matches any value.
+        // candidates are the positions in the policy of the only rules that can match, in policy order, or NULL to check every rule.
+        // They are only used when the view is not filtered.
+        PolicyView Select(int field_index, const vector<int>& field_symbols, const RuleList* candidates) const;
+
+        // FindFieldSymbols looks the filter values up in the symbol table, an empty value matches any value and gets the symbol -1.
+        // It returns false when a value is not in the symbol table, then it cannot match any rule.
+        static bool FindFieldSymbols(const SymbolTable& symbols, const vector<string>& field_values, vector<int>& field_symbols);
+
+        // GetRulesByColumn looks up the positions, in policy order, of the rules of the snapshot that have the symbol in the column.
+        // It returns false when some rule does not match the tokens, then every rule has to be checked.
+        // Removed rules can be among them.
+        bool GetRulesByColumn(int column, int symbol, RuleList& rules) const;
+
+        // Values returns a copy of the values of the rules in the view.
+        vector<vector<string>> Values() const;
+};
+
+#endif
@@ -24,6 +24,10 @@ Scope InitializeScope() {
     return duk_create_heap_default();
 }
 
+void DestroyScope(Scope scope) {
+    duk_destroy_heap(scope);
+}
+
 void PushFunctionValue(Scope scope, Function f, int nargs){
     duk_push_c_function(scope, f, (Index)nargs);
 }
@@ -64,11 +68,27 @@ void PushObjectValue(Scope scope){
     duk_push_global_object(scope);
 }
 
+void PushUndefinedValue(Scope scope){
+    duk_push_undefined(scope);
+}
+
+void PushNewObjectValue(Scope scope){
+    duk_push_object(scope);
+}
+
 void PushFunction(Scope scope, Function f, string fname, int nargs) {
     duk_push_c_function(scope, f, (Index)nargs);
     duk_put_global_string(scope, fname.c_str());
 }
 
+// PushBoundFunction adds a function that reads ptr back with GetBoundPointer whenever it is called.
+void PushBoundFunction(Scope scope, Function f, string fname, int nargs, void * ptr) {
+    duk_push_c_function(scope, f, (Index)nargs);
+    duk_push_pointer(scope, ptr);
+    duk_put_prop_string(scope, -2, DUK_HIDDEN_SYMBOL("ptr"));
+    duk_put_global_string(scope, fname.c_str());
+}
+
 void PushBoolean(Scope scope, bool expression, string identifier){
     duk_push_boolean(scope, expression);
     duk_put_global_string(scope, identifier.c_str());
@@ -116,74 +136,128 @@ void PushObject(Scope scope, string identifier){
     duk_put_global_string(scope, (identifier+"len").c_str());
 }
 
+void PushUndefined(Scope scope, string identifier){
+    duk_push_undefined(scope);
+    duk_put_global_string(scope, identifier.c_str());
+}
+
+// IncrementLength counts a property added to an object in the global "<obj>len", without evaluating any JavaScript.
+static void IncrementLength(Scope scope, string obj){
+    string identifier = obj + "len";
+    duk_get_global_string(scope, identifier.c_str());
+    duk_int_t len = duk_to_int(scope, -1);
+    duk_pop(scope);
+    duk_push_int(scope, len + 1);
+    duk_put_global_string(scope, identifier.c_str());
+}
+
 void PushFunctionPropToObject(Scope scope, string obj, Function f, string fname, int nargs) {
     duk_get_global_string(scope, obj.c_str());
     duk_push_c_function(scope, f, nargs);
     duk_put_prop_string(scope, -2, fname.c_str());
-    duk_eval_string_noresult(scope, (obj+"len += 1;").c_str());
+    duk_pop(scope);
+    IncrementLength(scope, obj);
 }
 
 void PushBooleanPropToObject(Scope scope, string obj, bool expression, string identifier){
     duk_get_global_string(scope, obj.c_str());
     duk_push_boolean(scope, expression);
     duk_put_prop_string(scope, -2, identifier.c_str());
-    duk_eval_string_noresult(scope, (obj+"len += 1;").c_str());
+    duk_pop(scope);
+    IncrementLength(scope, obj);
 }
 
 void PushTruePropToObject(Scope scope, string obj, string identifier){
     duk_get_global_string(scope, obj.c_str());
     duk_push_true(scope);
     duk_put_prop_string(scope, -2, identifier.c_str());
-    duk_eval_string_noresult(scope, (obj+"len += 1;").c_str());
+    duk_pop(scope);
+    IncrementLength(scope, obj);
 }
 
 void PushFalsePropToObject(Scope scope, string obj, string identifier){
     duk_get_global_string(scope, obj.c_str());
     duk_push_false(scope);
     duk_put_prop_string(scope, -2, identifier.c_str());
-    duk_eval_string_noresult(scope, (obj+"len += 1;").c_str());
+    duk_pop(scope);
+    IncrementLength(scope, obj);
 }
 
 void PushIntPropToObject(Scope scope, string obj, int integer, string identifier){
     duk_get_global_string(scope, obj.c_str());
     duk_push_int(scope, integer);
     duk_put_prop_string(scope, -2, identifier.c_str());
-    duk_eval_string_noresult(scope, (obj+"len += 1;").c_str());
+    duk_pop(scope);
+    IncrementLength(scope, obj);
 }
 
 void PushFloatPropToObject(Scope scope, string obj, float f, string identifier){
     duk_get_global_string(scope, obj.c_str());
     duk_push_number(scope, f);
     duk_put_prop_string(scope, -2, identifier.c_str());
-    duk_eval_string_noresult(scope, (obj+"len += 1;").c_str());
+    duk_pop(scope);
+    IncrementLength(scope, obj);
 }
 
 void PushDoublePropToObject(Scope scope, string obj, double d, string identifier){
     duk_get_global_string(scope, obj.c_str());
     duk_push_number(scope, d);
     duk_put_prop_string(scope, -2, identifier.c_str());
-    duk_eval_string_noresult(scope, (obj+"len += 1;").c_str());
+    duk_pop(scope);
+    IncrementLength(scope, obj);
 }
 
 void PushStringPropToObject(Scope scope, string obj, string s, string identifier){
     duk_get_global_string(scope, obj.c_str());
     duk_push_string(scope, s.c_str());
     duk_put_prop_string(scope, -2, identifier.c_str());
-    duk_eval_string_noresult(scope, (obj+"len += 1;").c_str());
+    duk_pop(scope);
+    IncrementLength(scope, obj);
 }
 
 void PushPointerPropToObject(Scope scope, string obj, void * ptr, string identifier){
     duk_get_global_string(scope, obj.c_str());
     duk_push_pointer(scope, ptr);
     duk_put_prop_string(scope, -2, identifier.c_str());
-    duk_eval_string_noresult(scope, (obj+"len += 1;").c_str());
+    duk_pop(scope);
+    IncrementLength(scope, obj);
 }
 
 void PushObjectPropToObject(Scope scope, string obj, string identifier){
     duk_get_global_string(scope, obj.c_str());
     duk_get_global_string(scope, identifier.c_str());
     duk_put_prop_string(scope, -2, identifier.c_str());
-    duk_eval_string_noresult(scope, (obj+"len += 1;").c_str());
+    duk_pop(scope);
+    IncrementLength(scope, obj);
+}
+
+void PushHeapPointerValue(Scope scope, HeapPointer ptr){
+    duk_push_heapptr(scope, ptr);
+}
+
+void PushHeapPointer(Scope scope, HeapPointer ptr, string identifier){
+    duk_push_heapptr(scope, ptr);
+    duk_put_global_string(scope, identifier.c_str());
+}
+
+// StashValue moves the value on top of the stack into the global stash, so that its heap pointer stays valid.
+HeapPointer StashValue(Scope scope, string identifier){
+    HeapPointer ptr = duk_get_heapptr(scope, -1);
+    duk_push_global_stash(scope);
+    duk_swap_top(scope, -2);
+    duk_put_prop_string(scope, -2, identifier.c_str());
+    duk_pop(scope);
+    return ptr;
+}
+
+// PushStringPropsToHeapObject writes values positionally into an object, keys holds the heap pointers of the interned property names.
+void PushStringPropsToHeapObject(Scope scope, HeapPointer obj, const vector<HeapPointer>& keys, const vector<const string*>& values){
+    duk_push_heapptr(scope, obj);
+    for(size_t i = 0 ; i < keys.size() ; i++){
+        duk_push_lstring(scope, values[i]->data(), values[i]->size());
+        duk_put_prop_heapptr(scope, -2, keys[i]);
+    }
+    duk_pop(scope);
 }
 
 Type CheckType(Scope scope){
@@ -201,6 +275,17 @@ unsigned int Size(Scope scope){
     return (unsigned int)duk_get_top(scope);
 }
 
+void SetSize(Scope scope, unsigned int size){
+    duk_set_top(scope, (Index)size);
+}
+
+StackGuard :: StackGuard(Scope scope) : scope(scope), top(Size(scope)) {
+}
+
+StackGuard :: ~StackGuard() {
+    SetSize(this->scope, this->top);
+}
+
 bool GetBoolean(Scope scope, int id){
     return bool(duk_to_boolean(scope, (Index)id));
 }
@@ -225,6 +310,15 @@ void* GetPointer(Scope scope, int id){
     return (void *)duk_to_pointer(scope, (Index)id);
 }
 
+// GetBoundPointer returns the pointer the running function was added with by PushBoundFunction.
+void* GetBoundPointer(Scope scope){
+    duk_push_current_function(scope);
+    duk_get_prop_string(scope, -1, DUK_HIDDEN_SYMBOL("ptr"));
+    void* ptr = duk_get_pointer(scope, -1);
+    duk_pop_2(scope);
+    return ptr;
+}
+
 void Get(Scope scope, string identifier){
     Eval(scope, identifier);
 }
@@ -236,4 +330,26 @@ bool Eval(Scope scope, string expression){
 
 void EvalNoResult(Scope scope, string expression){
     duk_eval_string_noresult(scope, expression.c_str());
+}
+
+// CompileFunction compiles the source of a function expression once and keeps it in the global stash under identifier.
+bool CompileFunction(Scope scope, string source, string identifier){
+    if(duk_pcompile_string(scope, DUK_COMPILE_FUNCTION, source.c_str()) != 0){
+        duk_pop(scope);
+        return false;
+    }
+    duk_push_global_stash(scope);
+    duk_swap_top(scope, -2);
+    duk_put_prop_string(scope, -2, identifier.c_str());
+    duk_pop(scope);
+    return true;
+}
+
+// CallFunction calls the function compiled under identifier with the nargs values on top of the stack, the result replaces them.
+bool CallFunction(Scope scope, string identifier, int nargs){
+    duk_push_global_stash(scope);
+    duk_get_prop_string(scope, -1, identifier.c_str());
+    duk_remove(scope, -2);
+    duk_insert(scope, (Index)(-(nargs + 1)));
+    return duk_pcall(scope, (Index)nargs) == 0;
 }
\ No newline at end of file
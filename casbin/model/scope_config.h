@@ -20,6 +20,7 @@
 #include "pch.h"
 
 #include <string>
+#include <vector>
 
 #include "../duktape/duktape.h"
 #include "../duktape/duk_config.h"
@@ -38,8 +39,10 @@ typedef duk_context PScope;
 typedef duk_ret_t ReturnType;
 typedef duk_c_function Function;
 typedef duk_idx_t Index;
+typedef void* HeapPointer;
 
 Scope InitializeScope();
+void DestroyScope(Scope scope);
 void PushFunctionValue(Scope scope, Function f, int nargs);
 void PushBooleanValue(Scope scope, bool expression);
 void PushTrueValue(Scope scope);
@@ -50,7 +53,10 @@ void PushDoubleValue(Scope scope, double d);
 void PushStringValue(Scope scope, string s);
 void PushPointerValue(Scope scope, void * ptr);
 void PushObjectValue(Scope scope);
+void PushUndefinedValue(Scope scope);
+void PushNewObjectValue(Scope scope);
 void PushFunction(Scope scope, Function f, string fname, int nargs);
+void PushBoundFunction(Scope scope, Function f, string fname, int nargs, void * ptr);
 void PushBoolean(Scope scope, bool expression, string identifier);
 void PushTrue(Scope scope, string identifier);
 void PushFalse(Scope scope, string identifier);
@@ -60,6 +66,7 @@ void PushDouble(Scope scope, double d, string identifier);
 void PushString(Scope scope, string s, string identifier);
 void PushPointer(Scope scope, void * ptr, string identifier);
 void PushObject(Scope scope, string identifier = "r");
+void PushUndefined(Scope scope, string identifier);
 void PushFunctionPropToObject(Scope scope, string obj, Function f, string fname, int nargs);
 void PushBooleanPropToObject(Scope scope, string obj, bool expression, string identifier);
 void PushTruePropToObject(Scope scope, string obj, string identifier);
@@ -70,17 +77,39 @@ void PushDoublePropToObject(Scope scope, string obj, double d, string identifier
 void PushStringPropToObject(Scope scope, string obj, string s, string identifier);
 void PushPointerPropToObject(Scope scope, string obj, void * ptr, string identifier);
 void PushObjectPropToObject(Scope scope, string obj, string identifier);
+void PushHeapPointerValue(Scope scope, HeapPointer ptr);
+void PushHeapPointer(Scope scope, HeapPointer ptr, string identifier);
+HeapPointer StashValue(Scope scope, string identifier);
+void PushStringPropsToHeapObject(Scope scope, HeapPointer obj, const vector<HeapPointer>& keys, const vector<const string*>& values);
 Type CheckType(Scope scope);
 bool FetchIdentifier(Scope scope, string identifier);
 unsigned int Size(Scope scope);
+void SetSize(Scope scope, unsigned int size);
 bool GetBoolean(Scope scope, int id = -1);
 int GetInt(Scope scope, int id = -1);
 float GetFloat(Scope scope, int id = -1);
 double GetDouble(Scope scope, int id = -1);
 string GetString(Scope scope, int id = -1);
 void* GetPointer(Scope scope, int id = -1);
+void* GetBoundPointer(Scope scope);
 void Get(Scope scope, string identifier);
 bool Eval(Scope scope, string expression);
 void EvalNoResult(Scope scope, string expression);
+bool CompileFunction(Scope scope, string source, string identifier);
+bool CallFunction(Scope scope, string identifier, int nargs);
+
+// StackGuard sets the value stack of a scope back to the size it had when the guard was created, on every exit of the enclosing block.
+class StackGuard {
+    private:
+
+        Scope scope;
+        unsigned int top;
+
+    public:
+
+        StackGuard(Scope scope);
+
+        ~StackGuard();
+};
 
 #endif
\ No newline at end of file
@@ -0,0 +1,137 @@
+/*
+* Copyright 2020 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "pch.h"
+
+#include "./symbol_table.h"
+
+SymbolTable :: Slots :: Slots(int capacity) : symbols(new atomic<int>[capacity]) {
+    this->capacity = capacity;
+    for (int i = 0 ; i < capacity ; i++)
+        this->symbols[i].store(-1, memory_order_relaxed);
+}
+
+SymbolTable :: SymbolTable() {
+    for (int k = 0 ; k < block_count ; k++)
+        this->blocks[k].store(NULL, memory_order_relaxed);
+    this->size.store(0, memory_order_relaxed);
+    this->current_slots = unique_ptr<Slots>(new Slots(64));
+    this->slots.store(this->current_slots.get(), memory_order_release);
+}
+
+SymbolTable :: ~SymbolTable() {
+    for (int k = 0 ; k < block_count ; k++)
+        delete[] this->blocks[k].load(memory_order_relaxed);
+}
+
+// Insert puts a symbol into the first free slot after the slot of its value.
+void SymbolTable :: Insert(Slots* slots, int symbol) {
+    int mask = slots->capacity - 1;
+    int i = int(hash<string>()(this->Value(symbol)) & mask);
+    while (slots->symbols[i].load(memory_order_relaxed) != -1)
+        i = (i + 1) & mask;
+    slots->symbols[i].store(symbol, memory_order_release);
+}
+
+// Intern returns the symbol of value, the value is added to the table if it is not there yet.
+int SymbolTable :: Intern(const string& value) {
+    lock_guard<mutex> guard(this->write_lock);
+
+    int symbol = this->Find(value);
+    if (symbol != -1)
+        return symbol;
+
+    // The value is stored before the symbol is published in the hash table, so a concurrent Find only sees complete values.
+    symbol = this->size.load(memory_order_relaxed);
+    int k = 31 - __builtin_clz(unsigned(symbol / first_block_size + 1));
+    if (this->blocks[k].load(memory_order_relaxed) == NULL)
+        this->blocks[k].store(new string[first_block_size << k], memory_order_release);
+    this->blocks[k].load(memory_order_relaxed)[symbol - first_block_size * ((1 << k) - 1)] = value;
+    this->size.store(symbol + 1, memory_order_release);
+
+    // The hash table is kept at most half full, a larger one is filled before it replaces it.
+    if ((symbol + 1) * 2 > this->current_slots->capacity) {
+        unique_ptr<Slots> slots(new Slots(this->current_slots->capacity * 2));
+        for (int i = 0 ; i <= symbol ; i++)
+            this->Insert(slots.get(), i);
+        this->slots.store(slots.get(), memory_order_release);
+        this->replaced_slots.push_back(move(this->current_slots));
+        this->current_slots = move(slots);
+    } else
+        this->Insert(this->current_slots.get(), symbol);
+
+    return symbol;
+}
+
+// Find returns the symbol of value, or -1 if the value is not in the table.
+int SymbolTable :: Find(const string& value) const {
+    Slots* slots = this->slots.load(memory_order_acquire);
+    int mask = slots->capacity - 1;
+    for (int i = int(hash<string>()(value) & mask) ; ; i = (i + 1) & mask) {
+        int symbol = slots->symbols[i].load(memory_order_acquire);
+        if (symbol == -1)
+            return -1;
+        if (this->Value(symbol) == value)
+            return symbol;
+    }
+}
+
+// Value returns the value of a symbol.
+const string& SymbolTable :: Value(int symbol) const {
+    // Block k starts at symbol first_block_size * (2^k - 1), so k is the highest bit of symbol / first_block_size + 1.
+    int k = 31 - __builtin_clz(unsigned(symbol / first_block_size + 1));
+    return this->blocks[k].load(memory_order_acquire)[symbol - first_block_size * ((1 << k) - 1)];
+}
+
+// InternAll returns the symbols of the values, interning the values that are not in the table yet.
+vector<int> SymbolTable :: InternAll(const vector<string>& values) {
+    vector<int> symbols(values.size());
+    for (int i = 0 ; i < values.size() ; i++)
+        symbols[i] = this->Intern(values[i]);
+    return symbols;
+}
+
+// FindAll looks up the symbols of the values, it returns false if some value is not in the table.
+bool SymbolTable :: FindAll(const vector<string>& values, vector<int>& symbols) const {
+    symbols.resize(values.size());
+    for (int i = 0 ; i < values.size() ; i++) {
+        symbols[i] = this->Find(values[i]);
+        if (symbols[i] == -1)
+            return false;
+    }
+    return true;
+}
+
+// ValuesOf returns the values of the symbols.
+vector<string> SymbolTable :: ValuesOf(const vector<int>& symbols) const {
+    vector<string> values(symbols.size());
+    for (int i = 0 ; i < symbols.size() ; i++)
+        values[i] = this->Value(symbols[i]);
+    return values;
+}
+
+int SymbolTable :: Size() const {
+    return this->size.load(memory_order_acquire);
+}
+
+size_t SymbolsHash :: operator()(const vector<int>& symbols) const {
+    size_t h = symbols.size();
+    for (int i = 0 ; i < symbols.size() ; i++)
+        h ^= size_t(symbols[i]) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    return h;
+}
@@ -0,0 +1,95 @@
+/*
+* Copyright 2020 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef CASBIN_CPP_MODEL_SYMBOL_TABLE
+#define CASBIN_CPP_MODEL_SYMBOL_TABLE
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// SymbolTable interns the values of the policy rules of an assertion, so that a rule is stored as fixed-width symbols
+// and two values are compared by comparing their symbols. Symbols are never removed, so a symbol and the
+// reference returned by Value stay valid as long as the table. The table is held by the snapshots of the policy:
+// a policy that is cleared, or whose values are mostly unused, interns its rules in a new table, and the old one
+// is freed with the last snapshot that holds it.
+// Values are interned by one writer at a time while Find and Value are called concurrently without a lock:
+// the values are stored in blocks that are never moved, and the hash table is replaced, not changed in place,
+// when it grows.
+class SymbolTable {
+    private:
+        // Block k holds first_block_size << k values, so the blocks never have to be moved.
+        static const int first_block_size = 16;
+        static const int block_count = 27;
+
+        // Slots is an open addressing hash table of symbols, with -1 in the free slots.
+        class Slots {
+            public:
+                int capacity;
+                unique_ptr<atomic<int>[]> symbols;
+
+                Slots(int capacity);
+        };
+
+        atomic<string*> blocks[block_count];
+        atomic<int> size;
+        atomic<Slots*> slots;
+        // replaced_slots keeps the tables that have been replaced, a concurrent Find may still be probing them.
+        vector<unique_ptr<Slots>> replaced_slots;
+        unique_ptr<Slots> current_slots;
+        // write_lock serializes Intern.
+        mutex write_lock;
+
+        void Insert(Slots* slots, int symbol);
+
+    public:
+
+        SymbolTable();
+
+        ~SymbolTable();
+
+        // Intern returns the symbol of value, the value is added to the table if it is not there yet.
+        int Intern(const string& value);
+
+        // Find returns the symbol of value, or -1 if the value is not in the table.
+        int Find(const string& value) const;
+
+        // Value returns the value of a symbol.
+        const string& Value(int symbol) const;
+
+        // InternAll returns the symbols of the values, interning the values that are not in the table yet.
+        vector<int> InternAll(const vector<string>& values);
+
+        // FindAll looks up the symbols of the values, it returns false if some value is not in the table.
+        bool FindAll(const vector<string>& values, vector<int>& symbols) const;
+
+        // ValuesOf returns the values of the symbols.
+        vector<string> ValuesOf(const vector<int>& symbols) const;
+
+        int Size() const;
+};
+
+// SymbolsHash hashes a sequence of symbols, e.g. a rule or the values of some of its fields.
+class SymbolsHash {
+    public:
+        size_t operator()(const vector<int>& symbols) const;
+};
+
+#endif
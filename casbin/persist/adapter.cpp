@@ -37,5 +37,5 @@ void LoadPolicyLine(string line, Model* model) {
     if (model->m.find(sec) == model->m.end())
         model->m[sec] = AssertionMap();
 
-    (model->m[sec].assertion_map[key]->policy).push_back(new_tokens);
+    model->m[sec].assertion_map[key]->AddRule(new_tokens);
 }
\ No newline at end of file
@@ -33,17 +33,19 @@ void FileAdapter :: SavePolicy(Model* model) {
     string tmp;
 
     for (unordered_map<string, shared_ptr<Assertion>> :: iterator it = model->m["p"].assertion_map.begin() ; it != model->m["p"].assertion_map.begin() ; it++){
-        for (int i = 0 ; i < it->second->policy.size() ; i++){
+        PolicyView policy = it->second->View();
+        for (int i = 0 ; i < policy.Size() ; i++){
             tmp += it->first + ", ";
-            tmp += ArrayToString(it->second->policy[i]);
+            tmp += ArrayToString(policy[i].Values());
             tmp += "\n";
         }
     }
 
     for (unordered_map <string, shared_ptr<Assertion>> :: iterator it = model->m["g"].assertion_map.begin() ; it != model->m["g"].assertion_map.begin() ; it++){
-        for (int i = 0 ; i < it->second->policy.size() ; i++){
+        PolicyView policy = it->second->View();
+        for (int i = 0 ; i < policy.Size() ; i++){
             tmp += it->first + ", ";
-            tmp += ArrayToString(it->second->policy[i]);
+            tmp += ArrayToString(policy[i].Values());
             tmp += "\n";
         }
     }
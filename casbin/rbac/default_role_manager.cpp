@@ -18,124 +18,365 @@
 
 #include "pch.h"
 
+#include <algorithm>
+
 #include "./default_role_manager.h"
 #include "../exception/casbin_rbac_exception.h"
 
-Role* Role :: NewRole(string name) {
-    Role* role = new Role;
-    role->name = name;
-    return role;
+Role :: Role(string name) : name(name) {
+    this->owner = 0;
+    this->reachable = NULL;
 }
 
-void Role :: AddRole(Role* role) {
-    for (int i = 0 ; i < this->roles.size() ; i++) {
-        if (this->roles[i]->name == role->name)
-            return;
-    }
+Role :: Role(const Role& other) : name(other.name), roles(other.roles), users(other.users), reachable_owner(other.reachable_owner) {
+    this->owner = 0;
+    this->reachable = this->reachable_owner.get();
+}
+
+bool Role :: HasDirectRole(int id) const {
+    return this->roles.Find(id) != NULL;
+}
+
+namespace {
+    // VisitMarks are the visited flags of the roles in a walk of a role graph. A role is visited if its mark is the
+    // generation of the walk, so the marks are not cleared for every walk. Each thread has its own.
+    class VisitMarks {
+        public:
+            vector<unsigned int> marks;
+            unsigned int generation;
+
+            VisitMarks() {
+                this->generation = 0;
+            }
+
+            // Begin starts a walk of a graph with size roles.
+            void Begin(int size) {
+                if (this->marks.size() < size)
+                    this->marks.resize(size);
+                if (++this->generation == 0) {
+                    fill(this->marks.begin(), this->marks.end(), 0);
+                    this->generation = 1;
+                }
+            }
+
+            // Visit marks a role as visited, it returns false if it was visited before.
+            bool Visit(int id) {
+                if (this->marks[id] == this->generation)
+                    return false;
+                this->marks[id] = this->generation;
+                return true;
+            }
+    };
+
+    thread_local VisitMarks visit_marks;
+}
+
+RoleGraph :: RoleGraph() : names(new SymbolTable()) {
+    this->owner = NewPersistentOwner();
+    this->copied = false;
+}
+
+// The copy shares the roles, both graphs copy a role before they change it.
+RoleGraph :: RoleGraph(const RoleGraph& other) : names(other.names), ids(other.ids), roles(other.roles) {
+    this->owner = NewPersistentOwner();
+    other.owner = NewPersistentOwner();
+    this->copied = true;
+}
+
+// Size returns the number of roles.
+int RoleGraph :: Size() const {
+    return this->roles.Size();
+}
 
-    this->roles.push_back(role);
+// Get returns the role id.
+const Role& RoleGraph :: Get(int id) const {
+    return *this->roles[id];
 }
 
-void Role :: DeleteRole(Role* role) {
-    for (int i = 0; i < roles.size();i++) {
-        if (roles[i]->name == role->name)
-            roles.erase(roles.begin()+i);
+// Own returns the role id for a change, it is copied first if it is shared with another graph.
+Role& RoleGraph :: Own(int id) {
+    Role* role = this->roles[id].get();
+    if (role->owner != this->owner) {
+        shared_ptr<Role> copy(new Role(*role));
+        copy->owner = this->owner;
+        this->roles.Set(id, copy);
+        role = copy.get();
     }
+    return *role;
+}
+
+// Copied returns true if the graph is a copy of another one.
+bool RoleGraph :: Copied() const {
+    return this->copied;
+}
+
+// Find returns the ID of the role name, -1 if there is none.
+int RoleGraph :: Find(const string& name) const {
+    int symbol = this->names->Find(name);
+    return symbol == -1 || symbol >= this->ids.Size() ? -1 : this->ids[symbol];
+}
+
+// Add returns the ID of the role name, the role is created if there is none.
+int RoleGraph :: Add(const string& name) {
+    int symbol = this->names->Intern(name);
+    while (this->ids.Size() <= symbol)
+        this->ids.PushBack(-1);
+    if (this->ids[symbol] != -1)
+        return this->ids[symbol];
+
+    int id = this->roles.Size();
+    this->ids.Set(symbol, id);
+    shared_ptr<Role> role(new Role(name));
+    role->owner = this->owner;
+    this->roles.PushBack(role);
+    return id;
 }
 
-bool Role :: HasRole(string name, int hierarchy_level) {
-    if (this->name == name)
+// AddLink makes the role id1 inherit the role id2.
+void RoleGraph :: AddLink(int id1, int id2) {
+    bool& linked = this->Own(id1).roles.Insert(id2);
+    if (linked)
+        return;
+
+    linked = true;
+    this->Own(id2).users.Insert(id1) = true;
+}
+
+// DeleteLink removes the link between the role id1 and the role id2.
+void RoleGraph :: DeleteLink(int id1, int id2) {
+    if (!this->Get(id1).HasDirectRole(id2))
+        return;
+
+    this->Own(id1).roles.Erase(id2);
+    this->Own(id2).users.Erase(id1);
+}
+
+// HasRole determines whether the role id inherits the role target within hierarchy_level levels.
+bool RoleGraph :: HasRole(int id, int target, int hierarchy_level) const {
+    if (id == target)
         return true;
 
-    if (hierarchy_level <= 0)
-        return false;
+    return this->HasRole(vector<int>(1, id), target, hierarchy_level);
+}
 
-    for(int i = 0 ; i < roles.size() ; i++){
-        if (roles[i]->HasRole(name, hierarchy_level - 1))
-            return true;
+// HasRole determines whether any of the roles ids inherits the role target within hierarchy_level levels.
+// The roles are visited level by level, each of them once, so the common ancestors of a diamond hierarchy are not walked again.
+bool RoleGraph :: HasRole(const vector<int>& ids, int target, int hierarchy_level) const {
+    visit_marks.Begin(this->Size());
+    vector<int> level;
+    for (int i = 0 ; i < ids.size() ; i++) {
+        if (visit_marks.Visit(ids[i]))
+            level.push_back(ids[i]);
+    }
+    for (int depth = 0 ; depth < hierarchy_level && !level.empty() ; depth++) {
+        vector<int> next;
+        for (int i = 0 ; i < level.size() ; i++) {
+            const PersistentMap<int, bool>& roles = this->Get(level[i]).roles;
+            for (PersistentMap<int, bool> :: Iterator it = roles.begin() ; it != roles.end() ; ++it) {
+                if (it.Key() == target)
+                    return true;
+                if (visit_marks.Visit(it.Key()))
+                    next.push_back(it.Key());
+            }
+        }
+        level.swap(next);
     }
 
     return false;
 }
 
-bool Role :: HasDirectRole(string name) {
-    for(int i = 0 ; i < roles.size() ; i++){
-        if (roles[i]->name == name)
-            return true;
+// Reachable returns the sorted IDs of the roles the role id inherits within hierarchy_level levels, its own ID included.
+// The roles are visited level by level, each of them once.
+vector<int> RoleGraph :: Reachable(int id, int hierarchy_level) const {
+    visit_marks.Begin(this->Size());
+    visit_marks.Visit(id);
+    vector<int> reachable(1, id);
+    int level_begin = 0;
+    for (int depth = 0 ; depth < hierarchy_level && level_begin < reachable.size() ; depth++) {
+        int level_end = int(reachable.size());
+        for (int i = level_begin ; i < level_end ; i++) {
+            const PersistentMap<int, bool>& roles = this->Get(reachable[i]).roles;
+            for (PersistentMap<int, bool> :: Iterator it = roles.begin() ; it != roles.end() ; ++it) {
+                if (visit_marks.Visit(it.Key()))
+                    reachable.push_back(it.Key());
+            }
+        }
+        level_begin = level_end;
     }
 
-    return false;
+    sort(reachable.begin(), reachable.end());
+    return reachable;
+}
+
+// Inheriting returns the IDs of the roles that inherit the role id within hierarchy_level levels, its own ID included.
+// The roles are visited level by level through their users, each of them once.
+vector<int> RoleGraph :: Inheriting(int id, int hierarchy_level) const {
+    visit_marks.Begin(this->Size());
+    visit_marks.Visit(id);
+    vector<int> inheriting(1, id);
+    int level_begin = 0;
+    for (int depth = 0 ; depth < hierarchy_level && level_begin < inheriting.size() ; depth++) {
+        int level_end = int(inheriting.size());
+        for (int i = level_begin ; i < level_end ; i++) {
+            const PersistentMap<int, bool>& users = this->Get(inheriting[i]).users;
+            for (PersistentMap<int, bool> :: Iterator it = users.begin() ; it != users.end() ; ++it) {
+                if (visit_marks.Visit(it.Key()))
+                    inheriting.push_back(it.Key());
+            }
+        }
+        level_begin = level_end;
+    }
+
+    return inheriting;
+}
+
+// GetRoles returns the names of the roles the role id inherits directly.
+vector<string> RoleGraph :: GetRoles(int id) const {
+    const PersistentMap<int, bool>& roles = this->Get(id).roles;
+    vector<string> names;
+    for (PersistentMap<int, bool> :: Iterator it = roles.begin() ; it != roles.end() ; ++it)
+        names.push_back(this->Get(it.Key()).name);
+
+    return names;
 }
 
-string Role :: ToString() {
-    if(this->roles.size()==0)
+// GetUsers returns the names of the roles that inherit the role id directly.
+vector<string> RoleGraph :: GetUsers(int id) const {
+    const PersistentMap<int, bool>& users = this->Get(id).users;
+    vector<string> names;
+    for (PersistentMap<int, bool> :: Iterator it = users.begin() ; it != users.end() ; ++it)
+        names.push_back(this->Get(it.Key()).name);
+
+    return names;
+}
+
+string RoleGraph :: ToString(int id) const {
+    const Role& role = this->Get(id);
+    if(role.roles.Size()==0)
         return "";
 
     string names = "";
-    if(this->roles.size() != 1)
+    if(role.roles.Size() != 1)
         names += "(";
 
-    for (int i = 0; i < roles.size(); i ++) {
-        Role* role = roles[i];
-        if (i == 0)
-            names += role->name;
+    bool first = true;
+    for (PersistentMap<int, bool> :: Iterator it = role.roles.begin() ; it != role.roles.end() ; ++it) {
+        if (first)
+            names += this->Get(it.Key()).name;
         else
-            names += ", " + role->name;
+            names += ", " + this->Get(it.Key()).name;
+        first = false;
     }
 
-    if(this->roles.size() != 1)
+    if(role.roles.Size() != 1)
         names += ")";
 
-    return name + " < " + names;
+    return role.name + " < " + names;
 }
 
-vector<string> Role :: GetRoles() {
-    vector<string> names;
-    for(int i = 0 ; i < roles.size() ; i++)
-        names.push_back(roles[i]->name);
-
-    return names;
-}
-
-bool DefaultRoleManager :: HasRole(string name) {
+bool DefaultRoleManager :: HasRole(const RoleGraph& graph, string name) {
     bool ok = false;
     if (this->has_pattern){
-        for (unordered_map<string, Role*> :: iterator it = this->all_roles.begin() ; it != this->all_roles.end() ; it++){
-            if (this->matching_func(name, it->first))
+        for (int i = 0 ; i < graph.Size() ; i++){
+            if (this->matching_func(name, graph.Get(i).name))
                 ok = true;
         }
     }
     else
-        ok = this->all_roles.find(name) != this->all_roles.end();
+        ok = graph.Find(name) != -1;
 
     return ok;
 }
 
-Role* DefaultRoleManager :: CreateRole(string name) {
-    Role* role;
-    bool ok = this->all_roles.find(name) != this->all_roles.end();
-    if (!ok) {
-        all_roles[name] = Role :: NewRole(name);
-        role = all_roles[name];
-    } else
-        role = all_roles[name];
+int DefaultRoleManager :: CreateRole(RoleGraph& graph, string name) {
+    int id = graph.Add(name);
 
     if (this->has_pattern) {
-        for (unordered_map<string, Role*> :: iterator it = this->all_roles.begin() ; it != this->all_roles.end() ; it++){
-            if (this->matching_func(name, it->first) && name!=it->first) {
-                Role* role1;
-                bool ok1 = this->all_roles.find(it->first) != this->all_roles.end();
-                if (!ok1) {
-                    all_roles[it->first] = Role :: NewRole(it->first);
-                    role1 = all_roles[it->first];
-                } else
-                    role1 = all_roles[it->first];
-                role->AddRole(role1);
-            }
+        for (int i = 0 ; i < graph.Size() ; i++){
+            if (this->matching_func(name, graph.Get(i).name) && name != graph.Get(i).name)
+                graph.AddLink(id, i);
         }
     }
 
-    return role;
+    return id;
+}
+
+// MatchedRoles returns the IDs of the roles the role name inherits directly, together with the roles that the matching function
+// links to it, in the order CreateRole would link them. The graph is not changed, so it can be the published one.
+vector<int> DefaultRoleManager :: MatchedRoles(const RoleGraph& graph, const string& name) {
+    vector<int> ids;
+    int id = graph.Find(name);
+    if (id != -1) {
+        const PersistentMap<int, bool>& roles = graph.Get(id).roles;
+        for (PersistentMap<int, bool> :: Iterator it = roles.begin() ; it != roles.end() ; ++it)
+            ids.push_back(it.Key());
+    }
+
+    for (int i = 0 ; i < graph.Size() ; i++){
+        if (this->matching_func(name, graph.Get(i).name) && name != graph.Get(i).name && (id == -1 || !graph.Get(id).HasDirectRole(i)))
+            ids.push_back(i);
+    }
+
+    return ids;
+}
+
+// Draft returns the unpublished version of the roles for a change, it is copied from the published one on the first change.
+RoleGraph& DefaultRoleManager :: Draft() {
+    if (this->draft == NULL) {
+        // The draft shares the roles of the published graph, readers stop caching in them once it exists.
+        lock_guard<mutex> cache_guard(this->cache_lock);
+        this->draft = shared_ptr<RoleGraph>(new RoleGraph(*atomic_load(&this->graph)));
+    }
+    return *this->draft;
+}
+
+// Reachable returns the cached reachable roles of the role id of a published graph, they are built on first use.
+// They are only cached while the graph is the current one and no draft shares its roles, otherwise built keeps them alive.
+const vector<int>* DefaultRoleManager :: Reachable(const RoleGraph& graph, int id, shared_ptr<const vector<int>>& built) {
+    const Role& role = graph.Get(id);
+    const vector<int>* reachable = role.reachable.load(memory_order_acquire);
+    if (reachable != NULL) {
+        this->link_cache_hits++;
+        return reachable;
+    }
+
+    this->link_cache_misses++;
+    built = shared_ptr<const vector<int>>(new vector<int>(graph.Reachable(id, this->max_hierarchy_level)));
+    lock_guard<mutex> guard(this->cache_lock);
+    if (this->draft != NULL || this->graph.get() != &graph)
+        return built.get();
+    if (role.reachable_owner == NULL) {
+        role.reachable_owner = built;
+        role.reachable.store(built.get(), memory_order_release);
+    }
+    return role.reachable_owner.get();
+}
+
+// InvalidateReachable drops the reachable roles of the draft that a change of the links of the role id can affect,
+// which are the ones that include id: the roles that inherit id within the hierarchy level, found through the users of the roles.
+void DefaultRoleManager :: InvalidateReachable(RoleGraph& graph, int id) {
+    // A new graph has not been published, so no reader has cached the reachable roles of its roles.
+    if (!graph.Copied())
+        return;
+
+    vector<int> inheriting = graph.Inheriting(id, this->max_hierarchy_level);
+    for (int i = 0 ; i < inheriting.size() ; i++){
+        if (graph.Get(inheriting[i]).reachable_owner == NULL)
+            continue;
+        Role& role = graph.Own(inheriting[i]);
+        role.reachable_owner.reset();
+        role.reachable = NULL;
+    }
+}
+
+// Publish makes the changes of the roles visible to the readers unless a batch is open, the replaced graph
+// is freed when the last reader releases it.
+void DefaultRoleManager :: Publish() {
+    if (this->update_depth > 0 || this->draft == NULL)
+        return;
+    lock_guard<mutex> guard(this->cache_lock);
+    atomic_store(&this->graph, shared_ptr<RoleGraph>(this->draft));
+    this->draft.reset();
 }
 
 /**
@@ -145,6 +386,10 @@ Role* DefaultRoleManager :: CreateRole(string name) {
  * @param max_hierarchy_level the maximized allowed RBAC hierarchy level.
  */
 DefaultRoleManager :: DefaultRoleManager(int max_hierarchy_level) {
+    this->graph = shared_ptr<RoleGraph>(new RoleGraph());
+    this->update_depth = 0;
+    this->link_cache_hits = 0;
+    this->link_cache_misses = 0;
     this->max_hierarchy_level = max_hierarchy_level;
     this->has_pattern = false;
 }
@@ -161,7 +406,11 @@ void DefaultRoleManager :: AddMatchingFunc(MatchingFunc fn) {
  * clear clears all stored data and resets the role manager to the initial state.
  */
 void DefaultRoleManager :: Clear() {
-    this->all_roles.clear();
+    {
+        lock_guard<mutex> guard(this->cache_lock);
+        this->draft = shared_ptr<RoleGraph>(new RoleGraph());
+    }
+    this->Publish();
 }
 
 // AddLink adds the inheritance link between role: name1 and role: name2.
@@ -174,9 +423,12 @@ void DefaultRoleManager :: AddLink(string name1, string name2, vector<string> do
     } else if (domain.size() > 1)
         throw CasbinRBACException("error: domain should be 1 parameter");
 
-    Role* role1 = this->CreateRole(name1);
-    Role* role2 = this->CreateRole(name2);
-    role1->AddRole(role2);
+    RoleGraph& graph = this->Draft();
+    int role1 = this->CreateRole(graph, name1);
+    int role2 = this->CreateRole(graph, name2);
+    graph.AddLink(role1, role2);
+    this->InvalidateReachable(graph, role1);
+    this->Publish();
 }
 
 /**
@@ -192,12 +444,15 @@ void DefaultRoleManager :: DeleteLink(string name1, string name2, vector<string>
     } else if (domain_length > 1)
         throw CasbinRBACException("error: domain should be 1 parameter");
 
-    if (!HasRole(name1) || !HasRole(name2))
+    RoleGraph& graph = this->Draft();
+    if (!HasRole(graph, name1) || !HasRole(graph, name2))
         throw CasbinRBACException("error: name1 or name2 does not exist");
 
-    Role* role1 = this->CreateRole(name1);
-    Role* role2 = this->CreateRole(name2);
-    role1->DeleteRole(role2);
+    int role1 = this->CreateRole(graph, name1);
+    int role2 = this->CreateRole(graph, name2);
+    graph.DeleteLink(role1, role2);
+    this->InvalidateReachable(graph, role1);
+    this->Publish();
 }
 
 /**
@@ -214,11 +469,33 @@ bool DefaultRoleManager :: HasLink(string name1, string name2, vector<string> do
 
     if (!name1.compare(name2))
         return true;
-    if (!HasRole(name1) || !HasRole(name2))
+
+    // The published graph is kept alive while it is read and it is never changed, so no lock is needed.
+    // Without a matching function the reachable roles of name1 are cached in it.
+    shared_ptr<RoleGraph> graph = atomic_load(&this->graph);
+    if (!this->has_pattern) {
+        int role1 = graph->Find(name1);
+        int role2 = graph->Find(name2);
+        if (role1 == -1 || role2 == -1)
+            return false;
+        shared_ptr<const vector<int>> built;
+        const vector<int>* reachable = this->Reachable(*graph, role1, built);
+        return binary_search(reachable->begin(), reachable->end(), role2);
+    }
+
+    // With a matching function the roles matched by name1 are looked up for every call and not added to the graph,
+    // so the reachable roles are not cached.
+    if (!HasRole(*graph, name1) || !HasRole(*graph, name2))
         return false;
 
-    Role* role1 = this->CreateRole(name1);
-    return role1->HasRole(name2, max_hierarchy_level);
+    int role2 = graph->Find(name2);
+    if (role2 == -1 || this->max_hierarchy_level <= 0)
+        return false;
+
+    vector<int> roles = this->MatchedRoles(*graph, name1);
+    if (find(roles.begin(), roles.end(), role2) != roles.end())
+        return true;
+    return graph->HasRole(roles, role2, this->max_hierarchy_level - 1);
 }
 
 /**
@@ -232,12 +509,19 @@ vector<string> DefaultRoleManager :: GetRoles(string name, vector<string> domain
     else if (domain_length > 1)
         throw CasbinRBACException("error: domain should be 1 parameter");
 
-    if (!HasRole(name)) {
+    shared_ptr<RoleGraph> graph = atomic_load(&this->graph);
+    if (!HasRole(*graph, name)) {
         vector<string> roles;
         return roles;
     }
 
-    vector<string> roles = this->CreateRole(name)->GetRoles();
+    vector<string> roles;
+    if (this->has_pattern) {
+        vector<int> ids = this->MatchedRoles(*graph, name);
+        for (int i = 0 ; i < ids.size() ; i++)
+            roles.push_back(graph->Get(ids[i]).name);
+    } else
+        roles = graph->GetRoles(graph->Find(name));
     if (domain_length == 1){
         for (int i = 0; i < roles.size(); i ++)
             roles[i] = roles[i].substr(domain[0].length() + 2, roles[i].length() - domain[0].length() - 2);
@@ -252,15 +536,15 @@ vector<string> DefaultRoleManager :: GetUsers(string name, vector<string> domain
     else if (domain.size() > 1)
         throw CasbinRBACException("error: domain should be 1 parameter");
 
-    if (!this->HasRole(name))
+    shared_ptr<RoleGraph> graph = atomic_load(&this->graph);
+    if (!this->HasRole(*graph, name))
         throw CasbinRBACException("error: name does not exist");
 
+    // In the members of the role, not in every role of the graph.
+    int id = graph->Find(name);
     vector<string> names;
-    for (unordered_map <string, Role*> :: iterator it = this->all_roles.begin() ; it != this->all_roles.end() ; it++){
-        Role* role = it->second;
-        if (role->HasDirectRole(name))
-            names.push_back(role->name);
-    }
+    if (id != -1)
+        names = graph->GetUsers(id);
 
     if (domain.size() == 1){
         for (int i = 0 ; i < names.size() ; i++)
@@ -280,10 +564,35 @@ void DefaultRoleManager :: PrintRoles() {
     // Logger *logger = &df_logger;
     // LogUtil::SetLogger(*logger);
 
-    string text = this->all_roles.begin()->second->ToString();
-    unordered_map<string, Role*> :: iterator it = this->all_roles.begin();
-    it++;
-    for ( ; it != this->all_roles.end() ; it++)
-        text += ", " + it->second->ToString();
+    shared_ptr<RoleGraph> graph = atomic_load(&this->graph);
+    if (graph->Size() == 0)
+        return;
+    string text = graph->ToString(0);
+    for (int i = 1 ; i < graph->Size() ; i++)
+        text += ", " + graph->ToString(i);
     // LogUtil::LogPrint(text);
-}
\ No newline at end of file
+}
+
+// GetLinkCacheCounts returns how many HasLink calls were answered from the cached reachable roles of a role (first)
+// and how many had to build them (second). Without a matching function every role is cached until a link that can change it changes.
+pair<unsigned long long, unsigned long long> DefaultRoleManager :: GetLinkCacheCounts() {
+    return pair<unsigned long long, unsigned long long>(this->link_cache_hits.load(), this->link_cache_misses.load());
+}
+
+// BeginUpdate starts a batch of link changes, the changes of a batch become visible to the readers together at EndUpdate.
+void DefaultRoleManager :: BeginUpdate() {
+    this->update_depth++;
+}
+
+// EndUpdate ends a batch of link changes started by BeginUpdate.
+void DefaultRoleManager :: EndUpdate() {
+    this->update_depth--;
+    this->Publish();
+}
+
+// CancelUpdate ends a batch of link changes started by BeginUpdate and drops the changes of all open batches.
+void DefaultRoleManager :: CancelUpdate() {
+    this->update_depth--;
+    lock_guard<mutex> guard(this->cache_lock);
+    this->draft.reset();
+}
@@ -17,9 +17,15 @@
 #ifndef CASBIN_CPP_RBAC_DEFAULT_ROLE_MANAGER
 #define CASBIN_CPP_RBAC_DEFAULT_ROLE_MANAGER
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
 
 #include "./role_manager.h"
+#include "../model/persistent_map.h"
+#include "../model/symbol_table.h"
 
 using namespace std;
 
@@ -27,40 +33,129 @@ typedef bool (*MatchingFunc)(string, string);
 
 /**
  * Role represents the data structure for a role in RBAC.
+ * It is a node of a role graph, the roles it inherits are referenced by their IDs in the graph.
  */
 class Role {
-    
+    public:
+        string name;
+        // roles are the IDs of the roles this role inherits directly and users are the IDs of the roles that inherit this role directly,
+        // both are hash sets, so a link is added, found and removed in constant time whatever the number of members of a role.
+        PersistentMap<int, bool> roles;
+        PersistentMap<int, bool> users;
+        // owner is the ID of the graph that changes the role in place, the other graphs that share it copy it first.
+        unsigned long owner;
+        // reachable caches the sorted IDs of the roles this role inherits within the hierarchy level of the role manager, its own ID included.
+        // It is NULL until HasLink needs it. It is read without locks, reachable_owner keeps it alive and is only set under the cache lock
+        // of the role manager while no draft is being changed, so the graphs that share the role can share it.
+        mutable atomic<const vector<int>*> reachable;
+        mutable shared_ptr<const vector<int>> reachable_owner;
+
+        Role(string name);
+
+        Role(const Role& other);
+
+        bool HasDirectRole(int id) const;
+};
+
+// RoleGraph is a version of the roles of a role manager. The roles reference each other by ID, their position in the graph,
+// and IDs are never reused in a graph. The roles are a persistent structure: a copy of a graph shares the roles with it,
+// and a role is copied when a copy changes it, so a copy takes time in the number of roles it changes.
+class RoleGraph {
     private:
-        vector <Role*> roles;
+        // names interns the names of the roles. It is shared with the copies of the graph, which only add names to it,
+        // so readers look names up in it while a copy adds roles.
+        shared_ptr<SymbolTable> names;
+        // ids maps the symbol of a name to the ID of its role, -1 for the names a dropped copy added.
+        PersistentVector<int> ids;
+        PersistentVector<shared_ptr<Role>> roles;
+        // owner is the ID of the roles the graph changes in place, it is replaced when the graph is copied.
+        mutable unsigned long owner;
+        // copied is true if the graph is a copy of another one, only then can its roles hold reachable roles before it is published.
+        bool copied;
 
     public:
-        string name;
 
-        static Role* NewRole(string name);
-        
-        void AddRole(Role* role);
+        RoleGraph();
+
+        // The copy shares the roles, both graphs copy a role before they change it.
+        RoleGraph(const RoleGraph& other);
+
+        // Size returns the number of roles.
+        int Size() const;
+
+        // Get returns the role id.
+        const Role& Get(int id) const;
+
+        // Own returns the role id for a change, it is copied first if it is shared with another graph.
+        Role& Own(int id);
+
+        // Copied returns true if the graph is a copy of another one.
+        bool Copied() const;
+
+        // Find returns the ID of the role name, -1 if there is none.
+        int Find(const string& name) const;
+
+        // Add returns the ID of the role name, the role is created if there is none.
+        int Add(const string& name);
+
+        // AddLink makes the role id1 inherit the role id2.
+        void AddLink(int id1, int id2);
 
-        void DeleteRole(Role* role);
+        // DeleteLink removes the link between the role id1 and the role id2.
+        void DeleteLink(int id1, int id2);
 
-        bool HasRole(string name, int hierarchy_level);
+        // HasRole determines whether the role id inherits the role target within hierarchy_level levels.
+        bool HasRole(int id, int target, int hierarchy_level) const;
 
-        bool HasDirectRole(string name);
+        // HasRole determines whether any of the roles ids inherits the role target within hierarchy_level levels.
+        bool HasRole(const vector<int>& ids, int target, int hierarchy_level) const;
 
-        string ToString();
+        // Reachable returns the sorted IDs of the roles the role id inherits within hierarchy_level levels, its own ID included.
+        vector<int> Reachable(int id, int hierarchy_level) const;
 
-        vector<string> GetRoles();
+        // Inheriting returns the IDs of the roles that inherit the role id within hierarchy_level levels, its own ID included.
+        vector<int> Inheriting(int id, int hierarchy_level) const;
+
+        // GetRoles returns the names of the roles the role id inherits directly.
+        vector<string> GetRoles(int id) const;
+
+        // GetUsers returns the names of the roles that inherit the role id directly.
+        vector<string> GetUsers(int id) const;
+
+        string ToString(int id) const;
 };
 
 class DefaultRoleManager : public RoleManager {
     private:
-        unordered_map <string, Role*> all_roles;
+        // graph is the published version of the roles, it is read and replaced with atomic operations, so the links are
+        // read without locks while they are changed. draft is the version the writer changes until it is published.
+        shared_ptr<RoleGraph> graph;
+        shared_ptr<RoleGraph> draft;
+        // update_depth counts the nested batches, the draft is published when the outermost one ends.
+        int update_depth;
         bool has_pattern;
         int max_hierarchy_level;
         MatchingFunc matching_func;
+        // cache_lock guards the reachable_owner of the roles of the published graph, which readers set when they cache the reachable roles,
+        // and the replacement of the draft and of the published graph, so that the roles a draft shares are not cached while it changes them.
+        mutex cache_lock;
+        // link_cache_hits and link_cache_misses count the HasLink calls answered from the reachable roles of a role and the ones that built them.
+        atomic<unsigned long long> link_cache_hits;
+        atomic<unsigned long long> link_cache_misses;
+
+        bool HasRole(const RoleGraph& graph, string name);
+
+        int CreateRole(RoleGraph& graph, string name);
+
+        vector<int> MatchedRoles(const RoleGraph& graph, const string& name);
 
-        bool HasRole(string name);
+        RoleGraph& Draft();
 
-        Role* CreateRole(string name);
+        const vector<int>* Reachable(const RoleGraph& graph, int id, shared_ptr<const vector<int>>& built);
+
+        void InvalidateReachable(RoleGraph& graph, int id);
+
+        void Publish();
 
     public:
 
@@ -112,6 +207,19 @@ class DefaultRoleManager : public RoleManager {
          * printRoles prints all the roles to log.
          */
         void PrintRoles();
+
+        // GetLinkCacheCounts returns how many HasLink calls were answered from the cached reachable roles of a role (first)
+        // and how many had to build them (second). Without a matching function every role is cached until a link that can change it changes.
+        pair<unsigned long long, unsigned long long> GetLinkCacheCounts();
+
+        // BeginUpdate starts a batch of link changes, the changes of a batch become visible to the readers together at EndUpdate.
+        void BeginUpdate();
+
+        // EndUpdate ends a batch of link changes started by BeginUpdate.
+        void EndUpdate();
+
+        // CancelUpdate ends a batch of link changes started by BeginUpdate and drops the changes of all open batches.
+        void CancelUpdate();
 };
 
 #endif
\ No newline at end of file
@@ -44,6 +44,13 @@ class RoleManager {
     virtual vector<string> GetUsers(string name, vector<string> domain = vector<string>{}) = 0;
     // PrintRoles prints all the roles to log.
     virtual void PrintRoles() = 0;
+    // BeginUpdate starts a batch of link changes, the changes of a batch become visible to the readers together at EndUpdate.
+    virtual void BeginUpdate() {}
+    // EndUpdate ends a batch of link changes started by BeginUpdate.
+    virtual void EndUpdate() {}
+    // CancelUpdate ends a batch of link changes started by BeginUpdate and drops the changes of all open batches,
+    // a role manager that does not batch its changes keeps them.
+    virtual void CancelUpdate() {}
 };
 
 #endif
\ No newline at end of file
@@ -204,24 +204,24 @@ bool IPMatch(string ip1, string ip2) {
     return objCIDR.net.contains(objIP1);
 }
 
-// GFunction is the method of the g(_, _) function.
-ReturnType GFunction(Scope scope) {
-    RoleManager* rm;
-    rm = (RoleManager*)GetPointer(scope, 0);
-    string name1 = GetString(scope, 1);
-    string name2 = GetString(scope, 2);
+// GFunctionWithRoleManager is the method of a g(_, _) function added with FunctionMap::AddGFunction,
+// the role manager is bound to the function instead of being passed as the first argument.
+ReturnType GFunctionWithRoleManager(Scope scope) {
+    shared_ptr<RoleManager>* rm = (shared_ptr<RoleManager>*)GetBoundPointer(scope);
+    string name1 = GetString(scope, 0);
+    string name2 = GetString(scope, 1);
 
     int len = Size(scope);
 
-    if(rm == NULL)
+    if(rm == NULL || *rm == NULL)
         PushBooleanValue(scope, name1 == name2);
-    else if (len == 3) {
+    else if (len == 2) {
         vector<string> domain;
-        bool res = rm->HasLink(name1, name2, domain);
+        bool res = (*rm)->HasLink(name1, name2, domain);
         PushBooleanValue(scope, res);
     } else {
-        vector<string> domain{GetString(scope, 3)};
-        bool res = rm->HasLink(name1, name2, domain);
+        vector<string> domain{GetString(scope, 2)};
+        bool res = (*rm)->HasLink(name1, name2, domain);
         PushBooleanValue(scope, res);
     }
 
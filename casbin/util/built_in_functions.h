@@ -43,7 +43,8 @@ bool RegexMatch(string key1, string key2);
 ReturnType IPMatch(Scope scope);
 bool IPMatch(string ip1, string ip2);
 
-// GFunction is the method of the g(_, _) function.
-ReturnType GFunction(Scope scope);
+// GFunctionWithRoleManager is the method of a g(_, _) function added with FunctionMap::AddGFunction,
+// the role manager is bound to the function instead of being passed as the first argument.
+ReturnType GFunctionWithRoleManager(Scope scope);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,30 @@
+<?php
+
+use Casbin\Enforcer;
+
+// Measures the memory the extension takes for the rules of a large policy.
+// The rules live outside of the PHP heap, so the resident set size of the process is compared before and after they are added.
+function rss() {
+    preg_match('/VmRSS:\s+(\d+)/', file_get_contents('/proc/self/status'), $matches);
+    return (int)$matches[1] * 1024;
+}
+
+function benchmark($rules_count, $chunk_size = 100000) {
+    $enforcer = new Enforcer("../examples/basic_model.conf", "../examples/basic_policy.csv");
+
+    $before = rss();
+    for ($start = 0; $start < $rules_count; $start += $chunk_size) {
+        $rules = [];
+        for ($i = $start; $i < min($start + $chunk_size, $rules_count); $i++) {
+            $rules[] = ["user" . ($i % 50000), "data" . intdiv($i, 50000) . "_" . ($i % 977), $i % 2 ? "read" : "write"];
+        }
+        $enforcer->addNamedPolicies("p", $rules);
+        unset($rules);
+    }
+    $used = rss() - $before;
+
+    printf("%8d rules %10.2f MB %8.1f bytes/rule\n", $rules_count, $used / 1048576, $used / $rules_count);
+}
+
+benchmark(100000);
+benchmark(1000000);
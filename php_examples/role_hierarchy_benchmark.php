@@ -0,0 +1,44 @@
+<?php
+
+use Casbin\Enforcer;
+
+// Measures Enforce() with a diamond-shaped role hierarchy: every role of a layer inherits every role of the next layer,
+// so a role is reached on width^depth paths. The request is denied, so the whole hierarchy is searched for the role of the rule.
+function benchmark($width, $depth, $users = 100) {
+    $enforcer = new Enforcer("../examples/rbac_model.conf", "../examples/rbac_policy.csv");
+
+    $links = [];
+    for ($k = 0; $k + 1 < $depth; $k++) {
+        for ($i = 0; $i < $width; $i++) {
+            for ($j = 0; $j < $width; $j++) {
+                $links[] = ["layer" . $k . "_" . $i, "layer" . ($k + 1) . "_" . $j];
+            }
+        }
+    }
+    for ($u = 0; $u < $users; $u++) {
+        for ($i = 0; $i < $width; $i++) {
+            $links[] = ["user" . $u, "layer0_" . $i];
+        }
+    }
+    $enforcer->addGroupingPolicies($links);
+    $enforcer->addNamedPolicies("p", [["isolated_role", "report", "read"]]);
+
+    // The first request of a user searches the hierarchy, the following ones are answered from the role manager's cache.
+    $start = microtime(true);
+    for ($u = 0; $u < $users; $u++) {
+        $enforcer->Enforce(["user" . $u, "report", "read"]);
+    }
+    $first = microtime(true) - $start;
+
+    $start = microtime(true);
+    for ($u = 0; $u < $users; $u++) {
+        $enforcer->Enforce(["user" . $u, "report", "read"]);
+    }
+    $again = microtime(true) - $start;
+
+    printf("width %2d depth %2d %10.2f us/op first %10.2f us/op again\n", $width, $depth, $first * 1000000 / $users, $again * 1000000 / $users);
+}
+
+benchmark(2, 10);
+benchmark(4, 10);
+benchmark(8, 10);